@@ -30,9 +30,27 @@
 // System
 
 // Standard Library
+#include <cmath>
 
 // Qt
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDateTime>
+#include <QtCore/QDirIterator>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QSemaphore>
+#include <QtCore/QSet>
+#include <QtCore/QTemporaryFile>
+#include <QtCore/QTextStream>
+#include <QtCore/QVarLengthArray>
+#include <QtCore/QtConcurrentMap>
 #include <QtGui/QComboBox>
+#include <QtGui/QDoubleSpinBox>
+#include <QtGui/QImage>
+#include <QtGui/QImageReader>
+#include <QtGui/QLineEdit>
+#include <QtGui/QSpinBox>
 
 // DS Public SDK
 #include "dzapp.h"
@@ -43,6 +61,7 @@
 #endif //DZ_SDK_4_12_OR_GREATER
 #include "dzdefaultmaterial.h"
 #include "dzenumproperty.h"
+#include "dzerclink.h"
 #include "dzfacegroup.h"
 #include "dzfacetmesh.h"
 #include "dzfacetshape.h"
@@ -57,6 +76,7 @@
 #include "dzmorph.h"
 #include "dzmorphdeltas.h"
 #include "dznode.h"
+#include "dznumericproperty.h"
 #include "dzobject.h"
 #include "dzpresentation.h"
 #include "dzprogress.h"
@@ -64,6 +84,7 @@
 #include "dzselectionmap.h"
 #include "dzsettings.h"
 #include "dzskinbinding.h"
+#include "dzstringproperty.h"
 #include "dzstyle.h"
 
 // Project Specific
@@ -85,9 +106,23 @@ const QString c_optTake( "Take" );
 
 const QString c_optIncRotationLimits( "IncludeRotationLimits" );
 const QString c_optIncAnimations( "IncludeAnimations" );
+const QString c_optKeyReductionTolerance( "KeyReductionTolerance" );
 
 const QString c_optIncPolygonSets( "IncludePolygonSets" );
 const QString c_optIncPolygonGroups( "IncludePolygonGroups" );
+const QString c_optWeldVertices( "WeldVertices" );
+const QString c_optWeldTolerance( "WeldTolerance" );
+
+const QString c_optMorphFilter( "MorphFilter" );
+const QString c_optMorphQuantizeDeltas( "MorphQuantizeDeltas" );
+const QString c_optMorphShareDuplicates( "MorphShareDuplicates" );
+
+const QString c_optMinimalFollowerSkeletons( "MinimalFollowerSkeletons" );
+const QString c_optSkinMaxInfluences( "SkinMaxInfluences" );
+const QString c_optSkinMinWeight( "SkinMinWeight" );
+
+const QString c_optTextureSearchPaths( "TextureSearchPaths" );
+const QString c_optTextureProxyMaxSize( "TextureProxyMaxSize" );
 
 const QString c_optStudioNodeNamesLabels( "IncludeNodeNamesLabels" );
 const QString c_optStudioPresentation( "IncludeNodePresentation" );
@@ -99,15 +134,38 @@ const QString c_optRunSilent( "RunSilent" );
 // settings default values
 const bool c_defaultIncludeRotationLimits = true;
 const bool c_defaultIncludeAnimations = false;
+const double c_defaultKeyReductionTolerance = 0.0;
 
 const bool c_defaultIncludePolygonSets = true;
 const bool c_defaultIncludePolygonGroups = false;
+const bool c_defaultWeldVertices = false;
+const double c_defaultWeldTolerance = 0.0001;
+const double c_minWeldTolerance = 0.000001;
+const double c_maxWeldTolerance = 0.1;
+
+const QString c_defaultMorphFilter;
+const bool c_defaultMorphQuantizeDeltas = false;
+const bool c_defaultMorphShareDuplicates = false;
+
+const bool c_defaultMinimalFollowerSkeletons = false;
+const int c_defaultSkinMaxInfluences = 0;
+const double c_defaultSkinMinWeight = 0.0;
+
+const QString c_defaultTextureSearchPaths;
+const int c_defaultTextureProxyMaxSize = 0;
 
 const bool c_defaultStudioNodeNames = true;
 const bool c_defaultStudioNodePresentation = true;
 const bool c_defaultStudioNodeSelectionMap = true;
 const bool c_defaultStudioSceneIDs = true;
 
+// the smallest key reduction tolerances, in the units of each kind of
+// property, so that noise on channels that barely change is removed too
+const double c_minTranslationKeyTolerance = 0.001; // cm
+const double c_minRotationKeyTolerance = 0.001; // degrees
+const double c_minScaleKeyTolerance = 0.00001;
+const double c_minMorphKeyTolerance = 0.00001;
+
 // functions
 DzFigure* createFigure()
 {
@@ -187,6 +245,7 @@ public:
 **/
 DzFbxImporter::DzFbxImporter() :
 	m_fbxRead( false ),
+	m_fbxReadSucceeded( false ),
 	m_fbxManager( NULL ),
 	m_fbxScene( NULL ),
 	m_fbxAnimStack( NULL ),
@@ -200,12 +259,24 @@ DzFbxImporter::DzFbxImporter() :
 	m_suppressRigErrors( false ),
 	m_includeRotationLimits( c_defaultIncludeRotationLimits ),
 	m_includeAnimations( c_defaultIncludeAnimations ),
+	m_keyReductionTolerance( c_defaultKeyReductionTolerance ),
 	m_includePolygonSets( c_defaultIncludePolygonSets ),
 	m_includePolygonGroups( c_defaultIncludePolygonGroups ),
+	m_weldVertices( c_defaultWeldVertices ),
+	m_weldTolerance( c_defaultWeldTolerance ),
+	m_morphFilter( c_defaultMorphFilter ),
+	m_morphQuantizeDeltas( c_defaultMorphQuantizeDeltas ),
+	m_morphShareDuplicates( c_defaultMorphShareDuplicates ),
+	m_minimalFollowerSkeletons( c_defaultMinimalFollowerSkeletons ),
+	m_skinMaxInfluences( c_defaultSkinMaxInfluences ),
+	m_skinMinWeight( c_defaultSkinMinWeight ),
+	m_textureSearchPaths( c_defaultTextureSearchPaths ),
+	m_textureProxyMaxSize( c_defaultTextureProxyMaxSize ),
 	m_studioNodeNamesLabels( c_defaultStudioNodeNames ),
 	m_studioNodePresentation( c_defaultStudioNodePresentation ),
 	m_studioNodeSelectionMap( c_defaultStudioNodeSelectionMap ),
 	m_studioSceneIDs( c_defaultStudioSceneIDs ),
+	m_pbrMatFactory( NULL ),
 	m_root( NULL )
 {}
 
@@ -283,11 +354,28 @@ void DzFbxImporter::getDefaultOptions( DzFileIOSettings* options ) const
 	// Properties
 	options->setBoolValue( c_optIncRotationLimits, c_defaultIncludeRotationLimits );
 	options->setBoolValue( c_optIncAnimations, c_defaultIncludeAnimations );
+	options->setFloatValue( c_optKeyReductionTolerance, c_defaultKeyReductionTolerance );
 	options->setStringValue( c_optTake, QString() );
 
 	// Geometry
 	options->setBoolValue( c_optIncPolygonSets, c_defaultIncludePolygonSets );
 	options->setBoolValue( c_optIncPolygonGroups, c_defaultIncludePolygonGroups );
+	options->setBoolValue( c_optWeldVertices, c_defaultWeldVertices );
+	options->setFloatValue( c_optWeldTolerance, c_defaultWeldTolerance );
+
+	// Morphs
+	options->setStringValue( c_optMorphFilter, c_defaultMorphFilter );
+	options->setBoolValue( c_optMorphQuantizeDeltas, c_defaultMorphQuantizeDeltas );
+	options->setBoolValue( c_optMorphShareDuplicates, c_defaultMorphShareDuplicates );
+
+	// Skinning
+	options->setBoolValue( c_optMinimalFollowerSkeletons, c_defaultMinimalFollowerSkeletons );
+	options->setIntValue( c_optSkinMaxInfluences, c_defaultSkinMaxInfluences );
+	options->setFloatValue( c_optSkinMinWeight, c_defaultSkinMinWeight );
+
+	// Textures
+	options->setStringValue( c_optTextureSearchPaths, c_defaultTextureSearchPaths );
+	options->setIntValue( c_optTextureProxyMaxSize, c_defaultTextureProxyMaxSize );
 
 	// Custom Data
 	options->setBoolValue( c_optStudioNodeNamesLabels, c_defaultStudioNodeNames );
@@ -298,37 +386,6 @@ void DzFbxImporter::getDefaultOptions( DzFileIOSettings* options ) const
 	options->setIntValue( c_optRunSilent, 0 );
 }
 
-
-namespace
-{
-
-class MapConversion {
-public:
-	QVector<double> fbxWeights;
-	unsigned short* dsWeights;
-};
-
-bool isChildNode( DzNode* child, DzNode* parent )
-{
-	if ( !parent || !child || child == parent )
-	{
-		return false;
-	}
-
-	while ( child )
-	{
-		if ( child == parent )
-		{
-			return true;
-		}
-		child = child->getNodeParent();
-	}
-
-	return false;
-}
-
-} //namespace
-
 /**
 	Manually get the options. If the "RunSilent" option is true, then the dialog
 	will be skipped.
@@ -463,6 +520,11 @@ void DzFbxImporter::fbxRead( const QString &filename )
 
 	fbxImporter->GetFileVersion( m_fbxFileMajor, m_fbxFileMinor, m_fbxFileRevision );
 
+	// where the SDK extracts embedded media by default
+	const QFileInfo fileInfo( filename );
+	m_embeddedMediaPath = fileInfo.absoluteDir().filePath( fileInfo.completeBaseName() + ".fbm" );
+
+	bool extractEmbeddedMedia = false;
 	if ( fbxImporter->IsFBX() )
 	{
 		fbxIoSettings->SetBoolProp( IMP_FBX_MATERIAL, true );
@@ -472,6 +534,8 @@ void DzFbxImporter::fbxRead( const QString &filename )
 		fbxIoSettings->SetBoolProp( IMP_FBX_GOBO, true );
 		fbxIoSettings->SetBoolProp( IMP_FBX_ANIMATION, true );
 		fbxIoSettings->SetBoolProp( IMP_FBX_GLOBAL_SETTINGS, true );
+
+		extractEmbeddedMedia = fbxPrepareEmbeddedMedia( filename, fbxImporter, fbxIoSettings );
 	}
 
 #if FBXSDK_VERSION_MAJOR >= 2020
@@ -481,6 +545,11 @@ void DzFbxImporter::fbxRead( const QString &filename )
 	fbxImporter->Import( m_fbxScene );
 
 	FbxStatus status = fbxImporter->GetStatus();
+	if ( status == FbxStatus::eSuccess && extractEmbeddedMedia )
+	{
+		fbxFinishEmbeddedMedia( filename );
+	}
+
 	if ( status != FbxStatus::eSuccess )
 	{
 #if FBXSDK_VERSION_MAJOR >= 2020
@@ -520,6 +589,7 @@ void DzFbxImporter::fbxRead( const QString &filename )
 	m_fbxOrigAppVersion = fbxSceneInfo->Original_ApplicationVersion;
 
 	m_fbxRead = true;
+	m_fbxReadSucceeded = status == FbxStatus::eSuccess;
 }
 
 /**
@@ -572,6 +642,399 @@ void DzFbxImporter::fbxPickAnimation()
 	}
 }
 
+/**
+	@return	The origin of the node, which is only looked up once per import;
+			origins do not change once the graph has been imported.
+**/
+DzVec3 DzFbxImporter::getCachedOrigin( DzNode* dsNode )
+{
+	QHash<DzNode*, DzVec3>::const_iterator originIt = m_originCache.constFind( dsNode );
+	if ( originIt != m_originCache.constEnd() )
+	{
+		return originIt.value();
+	}
+
+	const DzVec3 origin = dsNode->getOrigin();
+	m_originCache.insert( dsNode, origin );
+
+	return origin;
+}
+
+/**
+	@return	true if the node is a descendant of the figure, using the nearest
+			figure ancestor of each node as recorded by fbxImportGraph(), so
+			that only figures are visited rather than every ancestor.
+**/
+bool DzFbxImporter::isInFigure( DzNode* dsNode, DzFigure* dsFigure ) const
+{
+	if ( !dsNode || !dsFigure )
+	{
+		return false;
+	}
+
+	for ( DzFigure* dsAncestor = m_figureAncestorMap.value( dsNode ); dsAncestor; dsAncestor = m_figureAncestorMap.value( dsAncestor ) )
+	{
+		if ( dsAncestor == dsFigure )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+namespace
+{
+
+/**
+	@return	A bind pose that references a node with a global matrix, or NULL if
+			there is none. If there is more than one, the last is returned.
+**/
+FbxPose* findBindPose( const QMultiHash<FbxNode*, QPair<FbxPose*, int> > &bindPoseMap, FbxNode* fbxNode )
+{
+	QMultiHash<FbxNode*, QPair<FbxPose*, int> >::const_iterator bindPoseIt = bindPoseMap.constFind( fbxNode );
+	for ( ; bindPoseIt != bindPoseMap.constEnd() && bindPoseIt.key() == fbxNode; ++bindPoseIt )
+	{
+		FbxPose* pose = bindPoseIt.value().first;
+		if ( !pose->IsLocalMatrix( bindPoseIt.value().second ) )
+		{
+			return pose;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+	@return	true if every element of two matrices is equal, within a
+			tolerance relative to the values.
+**/
+bool isFuzzyMatrixMatch( const FbxMatrix &fbxMatrix, const FbxAMatrix &fbxAMatrix )
+{
+	const double tolerance = 1e-4;
+	for ( int i = 0; i < 4; i++ )
+	{
+		for ( int j = 0; j < 4; j++ )
+		{
+			const double value = fbxAMatrix.Get( i, j );
+			if ( qAbs( fbxMatrix.Get( i, j ) - value ) > tolerance * qMax( 1.0, qAbs( value ) ) )
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+	@return	true if a cluster link matrix matches the bind pose matrix of the
+			node it is linked to. If the mesh is in a bind pose, only that pose
+			is compared against, since it is the pose the mesh was bound in;
+			otherwise the link matrix matches if it matches any bind pose of
+			the node. Matrices that are local to the parent of the node are
+			not comparable, so they are skipped. Also true if there is nothing
+			to compare against.
+**/
+bool isBindPoseMatch( const QMultiHash<FbxNode*, QPair<FbxPose*, int> > &bindPoseMap, const FbxPose* meshBindPose,
+	FbxNode* fbxLinkNode, const FbxAMatrix &fbxLinkMatrix )
+{
+	bool compared = false;
+
+	QMultiHash<FbxNode*, QPair<FbxPose*, int> >::const_iterator bindPoseIt = bindPoseMap.constFind( fbxLinkNode );
+	for ( ; bindPoseIt != bindPoseMap.constEnd() && bindPoseIt.key() == fbxLinkNode; ++bindPoseIt )
+	{
+		FbxPose* pose = bindPoseIt.value().first;
+		const int poseIdx = bindPoseIt.value().second;
+		if ( ( meshBindPose && pose != meshBindPose )
+			|| pose->IsLocalMatrix( poseIdx ) )
+		{
+			continue;
+		}
+
+		if ( isFuzzyMatrixMatch( pose->GetMatrix( poseIdx ), fbxLinkMatrix ) )
+		{
+			return true;
+		}
+
+		compared = true;
+	}
+
+	return !compared;
+}
+
+/**
+	Converts cluster link matrices into bone binding matrices; the rotation
+	part is copied, and the translation is negated and offset by the origin
+	of the bone relative to the figure.
+**/
+void toBindingMatrices( const FbxAMatrix* linkMatrices, const DzVec3* originOffsets, int count, DzMatrix3* bindingMatrices )
+{
+	for ( int m = 0; m < count; m++ )
+	{
+		const FbxAMatrix &fbxMatrix = linkMatrices[m];
+		const DzVec3 &offset = originOffsets[m];
+		DzMatrix3 &dsMatrix = bindingMatrices[m];
+
+		dsMatrix[0][0] =  fbxMatrix[0][0];
+		dsMatrix[0][1] =  fbxMatrix[0][1];
+		dsMatrix[0][2] =  fbxMatrix[0][2];
+		dsMatrix[1][0] =  fbxMatrix[1][0];
+		dsMatrix[1][1] =  fbxMatrix[1][1];
+		dsMatrix[1][2] =  fbxMatrix[1][2];
+		dsMatrix[2][0] =  fbxMatrix[2][0];
+		dsMatrix[2][1] =  fbxMatrix[2][1];
+		dsMatrix[2][2] =  fbxMatrix[2][2];
+		dsMatrix[3][0] = -fbxMatrix[3][0] + offset[0];
+		dsMatrix[3][1] = -fbxMatrix[3][1] + offset[1];
+		dsMatrix[3][2] = -fbxMatrix[3][2] + offset[2];
+	}
+}
+
+const int c_skinWeightRangeSize = 16384;
+
+struct SkinWeightRange
+{
+	SkinWeightRange( int begin = 0, int end = 0 ) :
+		begin( begin ), end( end )
+	{}
+
+	int	begin;
+	int	end;
+};
+
+/**
+	Normalizes the sparse skin weight rows of a range of vertices and
+	quantizes them into weight map arrays in a single pass. Each row is
+	normalized in double precision and quantized by rounding the running
+	total, so that the rounding error is carried to the next influence and
+	the quantized weights of a vertex always sum to exactly DZ_USHORT_MAX.
+	Vertices without any weight are left unweighted.
+
+	Ranges do not overlap, so instances can be invoked concurrently.
+**/
+class QuantizeSkinWeights {
+public:
+	QuantizeSkinWeights( const int* begins, const int* ends, const int* maps,
+		const double* weights, unsigned short* const* dsWeights ) :
+		m_begins( begins ), m_ends( ends ), m_maps( maps ),
+		m_weights( weights ), m_dsWeights( dsWeights )
+	{}
+
+	void operator()( const SkinWeightRange &range ) const
+	{
+		for ( int v = range.begin; v < range.end; v++ )
+		{
+			const int rowBegin = m_begins[v];
+			const int rowEnd = m_ends[v];
+
+			double sum = 0.0;
+			for ( int k = rowBegin; k < rowEnd; k++ )
+			{
+				sum += m_weights[k];
+			}
+
+			if ( sum <= 0.0 )
+			{
+				continue;
+			}
+
+			const double scale = DZ_USHORT_MAX / sum;
+			double total = 0.0;
+			int quantized = 0;
+			for ( int k = rowBegin; k < rowEnd - 1; k++ )
+			{
+				total += m_weights[k] * scale;
+				const int rounded = qBound( quantized, qRound( total ), int( DZ_USHORT_MAX ) );
+				m_dsWeights[m_maps[k]][v] = static_cast<unsigned short>( rounded - quantized );
+				quantized = rounded;
+			}
+
+			m_dsWeights[m_maps[rowEnd - 1]][v] = static_cast<unsigned short>( DZ_USHORT_MAX - quantized );
+		}
+	}
+
+private:
+	const int*				m_begins;
+	const int*				m_ends;
+	const int*				m_maps;
+	const double*			m_weights;
+	unsigned short* const*	m_dsWeights;
+};
+
+} //namespace
+
+/**
+	Gathers the weights of the clusters of a skin into compressed sparse rows
+	of (map, weight) influences per vertex; the influences of vertex v are at
+	[begins[v], ends[v]). Only the influences that are present are stored,
+	rather than a dense array per cluster, so the memory used scales with the
+	number of influences instead of vertices times bones.
+
+	Control points are counted in a first pass over the cluster indices, then
+	the rows are filled in a single pass over the cluster indices and weights.
+	If a cluster lists a control point more than once the last weight is kept.
+
+	The dual quaternion blend weights of a blended skin are gathered in the
+	same pass, as (vertex, weight) pairs, since they are typically only
+	present for a fraction of the vertices.
+
+	@param weld			The map from control points to vertices.
+	@param fbxSkin		The skin the clusters belong to.
+	@param clusters		The clusters to gather; the index of a cluster is the
+						index of the map its influences refer to.
+	@param skinWeights	Receives the rows.
+**/
+void DzFbxImporter::fbxGatherSkinWeights( const VertexWeld &weld, const FbxSkin* fbxSkin, const QVector<FbxCluster*> &clusters, SkinWeights &skinWeights )
+{
+	const int numVertices = weld.numVertices;
+
+	skinWeights.blendVertices.clear();
+	skinWeights.blendWeights.clear();
+	skinWeights.hasBlendWeights = false;
+
+	const int numBlendIndices = fbxSkin->GetSkinningType() == FbxSkin::eBlend ? fbxSkin->GetControlPointIndicesCount() : 0;
+	const int* fbxBlendIndices = fbxSkin->GetControlPointIndices();
+	const double* fbxBlendWeights = fbxSkin->GetControlPointBlendWeights();
+	if ( numBlendIndices > 0 && fbxBlendIndices && fbxBlendWeights )
+	{
+		skinWeights.blendVertices.reserve( numBlendIndices );
+		skinWeights.blendWeights.reserve( numBlendIndices );
+		for ( int k = 0; k < numBlendIndices; k++ )
+		{
+			const int cpIdx = fbxBlendIndices[k];
+			if ( !weld.contains( cpIdx )
+				|| !weld.isSource( cpIdx ) )
+			{
+				continue;
+			}
+
+			skinWeights.blendVertices.append( weld.vertex( cpIdx ) );
+			skinWeights.blendWeights.append( fbxBlendWeights[k] );
+			skinWeights.hasBlendWeights |= fbxBlendWeights[k] != 0.0;
+		}
+	}
+
+	skinWeights.begins.fill( 0, numVertices + 1 );
+	for ( int m = 0; m < clusters.count(); m++ )
+	{
+		const FbxCluster* fbxCluster = clusters[m];
+		const int* fbxIndices = fbxCluster->GetControlPointIndices();
+		for ( int k = 0, n = fbxCluster->GetControlPointIndicesCount(); k < n; k++ )
+		{
+			const int cpIdx = fbxIndices[k];
+			if ( weld.contains( cpIdx )
+				&& weld.isSource( cpIdx ) )
+			{
+				skinWeights.begins[weld.vertex( cpIdx ) + 1]++;
+			}
+		}
+	}
+
+	for ( int v = 0; v < numVertices; v++ )
+	{
+		skinWeights.begins[v + 1] += skinWeights.begins[v];
+	}
+
+	const int numInfluences = skinWeights.begins[numVertices];
+	skinWeights.ends = skinWeights.begins;
+	skinWeights.maps.resize( numInfluences );
+	skinWeights.weights.resize( numInfluences );
+
+	for ( int m = 0; m < clusters.count(); m++ )
+	{
+		const FbxCluster* fbxCluster = clusters[m];
+		const int* fbxIndices = fbxCluster->GetControlPointIndices();
+		const double* fbxWeights = fbxCluster->GetControlPointWeights();
+		for ( int k = 0, n = fbxCluster->GetControlPointIndicesCount(); k < n; k++ )
+		{
+			const int cpIdx = fbxIndices[k];
+			if ( !weld.contains( cpIdx )
+				|| !weld.isSource( cpIdx ) )
+			{
+				continue;
+			}
+
+			const int v = weld.vertex( cpIdx );
+
+			// clusters are filled in order, so a repeat from the same
+			// cluster is always the last influence in the row
+			int &rowEnd = skinWeights.ends[v];
+			if ( rowEnd > skinWeights.begins[v]
+				&& skinWeights.maps[rowEnd - 1] == m )
+			{
+				skinWeights.weights[rowEnd - 1] = fbxWeights[k];
+				continue;
+			}
+
+			skinWeights.maps[rowEnd] = m;
+			skinWeights.weights[rowEnd] = fbxWeights[k];
+			rowEnd++;
+		}
+	}
+}
+
+/**
+	Limits the influences of each vertex to the strongest, in place. The rows
+	are sorted by descending weight and truncated; the remaining weights are
+	renormalized when they are quantized. At least one influence is always
+	kept for a vertex that has any.
+
+	@param skinWeights		The rows to prune.
+	@param maxInfluences	The maximum number of influences per vertex, or 0
+							for no limit.
+	@param minWeight		Influences with a weight below this fraction of
+							the total weight of the vertex are removed.
+**/
+void DzFbxImporter::pruneSkinWeights( SkinWeights &skinWeights, int maxInfluences, double minWeight )
+{
+	int* maps = skinWeights.maps.data();
+	double* weights = skinWeights.weights.data();
+
+	for ( int v = 0, n = skinWeights.ends.count() - 1; v < n; v++ )
+	{
+		const int rowBegin = skinWeights.begins[v];
+		const int rowEnd = skinWeights.ends[v];
+		if ( rowEnd - rowBegin < 2 )
+		{
+			continue;
+		}
+
+		// rows are short, so an insertion sort is sufficient
+		double sum = weights[rowBegin];
+		for ( int k = rowBegin + 1; k < rowEnd; k++ )
+		{
+			const int map = maps[k];
+			const double weight = weights[k];
+			sum += weight;
+
+			int l = k;
+			for ( ; l > rowBegin && weights[l - 1] < weight; l-- )
+			{
+				maps[l] = maps[l - 1];
+				weights[l] = weights[l - 1];
+			}
+
+			maps[l] = map;
+			weights[l] = weight;
+		}
+
+		int keep = rowEnd - rowBegin;
+		if ( maxInfluences > 0 )
+		{
+			keep = qMin( keep, maxInfluences );
+		}
+
+		const double threshold = minWeight * sum;
+		while ( keep > 1 && weights[rowBegin + keep - 1] < threshold )
+		{
+			keep--;
+		}
+
+		skinWeights.ends[v] = rowBegin + keep;
+	}
+}
+
 /**
 **/
 void DzFbxImporter::fbxImportSkinning()
@@ -582,11 +1045,10 @@ void DzFbxImporter::fbxImportSkinning()
 		Skinning skinning = m_skins[i];
 
 		const Node* node = skinning.node;
-		Q_UNUSED( node )
-
 		FbxSkin* fbxSkin = skinning.fbxSkin;
 		DzFigure* dsFigure = skinning.dsFigure;
-		const int numVertices = skinning.numVertices;
+		const VertexWeld &weld = skinning.weld;
+		const int numVertices = weld.numVertices;
 
 		DzSkinBinding* dsSkin = dsFigure->getSkinBinding();
 
@@ -623,6 +1085,8 @@ void DzFbxImporter::fbxImportSkinning()
 
 		DzSkeleton* dsBaseSkeleton = NULL;
 
+		QVector<FbxCluster*> boundClusters;
+		QVector<DzBone*> boundBones;
 		for ( int j = 0; j < numClusters; j++ )
 		{
 			FbxCluster* fbxCluster = fbxSkin->GetCluster( j );
@@ -632,88 +1096,161 @@ void DzFbxImporter::fbxImportSkinning()
 				continue;
 			}
 
-			if ( !isChildNode( dsBone, dsFigure ) )
+			if ( !isInFigure( dsBone, dsFigure ) )
 			{
+				// a previous skin may have replicated the skeleton, which maps
+				// the linked nodes to the (possibly minimal) bones of its
+				// follower, so the skeleton that is followed is used instead
 				dsBaseSkeleton = dsBone->getSkeleton();
+				while ( DzSkeleton* dsTarget = dsBaseSkeleton->getFollowTarget() )
+				{
+					dsBaseSkeleton = dsTarget;
+				}
 			}
+
+			boundClusters.append( fbxCluster );
+			boundBones.append( dsBone );
 		}
 
+		// replication maps the linked nodes to the bones of the follower,
+		// so the bones are resolved again
 		if ( dsBaseSkeleton )
 		{
 			replicateSkeleton( dsBaseSkeleton, skinning );
+
+			for ( int m = 0; m < boundClusters.count(); m++ )
+			{
+				if ( DzBone* dsBone = qobject_cast<DzBone*>( m_nodeMap.value( boundClusters[m]->GetLink() ) ) )
+				{
+					boundBones[m] = dsBone;
+				}
+			}
 		}
 
+		SkinWeights skinWeights;
+		fbxGatherSkinWeights( weld, fbxSkin, boundClusters, skinWeights );
 
-		DzWeightMapList maps;
-		QVector<MapConversion> mapConversions;
-		for ( int j = 0; j < numClusters; j++ )
+		// when influences are pruned, bones that are left without any are
+		// not bound at all
+		const bool pruneInfluences = m_skinMaxInfluences > 0 || m_skinMinWeight > 0.0;
+		QVector<bool> influencing( boundClusters.count(), !pruneInfluences );
+		if ( pruneInfluences )
 		{
-			FbxCluster* fbxCluster = fbxSkin->GetCluster( j );
-			DzBone* dsBone = qobject_cast<DzBone*>( m_nodeMap.value( fbxCluster->GetLink() ) );
-			if ( !dsBone )
+			pruneSkinWeights( skinWeights, m_skinMaxInfluences, m_skinMinWeight );
+
+			for ( int v = 0; v < numVertices; v++ )
 			{
-				continue;
+				for ( int k = skinWeights.begins[v]; k < skinWeights.ends[v]; k++ )
+				{
+					influencing[skinWeights.maps[k]] = true;
+				}
 			}
+		}
 
-			DzBoneBinding* dsBinding = new DzBoneBinding();
-			dsBinding->setBone( dsBone );
-			dsSkin->addBoneBinding( dsBinding );
+		// the link matrices are gathered and converted to binding matrices
+		// together
+		const int numBound = boundClusters.count();
+		const DzVec3 skelOrigin = dsFigure->getOrigin();
+		QVector<FbxAMatrix> linkMatrices( numBound );
+		QVector<DzVec3> originOffsets( numBound );
+		for ( int m = 0; m < numBound; m++ )
+		{
+			boundClusters[m]->GetTransformLinkMatrix( linkMatrices[m] );
 
-			DzWeightMap* dsWeightMap  = new DzWeightMap( numVertices );
-			int* fbxIndices = fbxCluster->GetControlPointIndices();
-			double* fbxWeights = fbxCluster->GetControlPointWeights();
+			originOffsets[m] = getCachedOrigin( boundBones[m] );
+			originOffsets[m] -= skelOrigin;
+		}
 
-			MapConversion mapConv;
-			mapConv.dsWeights = dsWeightMap->getWeights();
-			mapConv.fbxWeights.resize( numVertices );
-			for ( int k = 0; k < fbxCluster->GetControlPointIndicesCount(); k++ )
+		// the link matrices must match the bind pose; this is checked here,
+		// rather than before the import, so that imports that do not show
+		// the options dialog report it too
+		if ( !m_suppressRigErrors )
+		{
+			const FbxPose* meshBindPose = findBindPose( m_bindPoseMap, node->fbxNode );
+			for ( int m = 0; m < numBound; m++ )
 			{
-				mapConv.fbxWeights[fbxIndices[k]] = fbxWeights[k];
+				FbxNode* fbxLinkNode = boundClusters[m]->GetLink();
+				if ( !isBindPoseMatch( m_bindPoseMap, meshBindPose, fbxLinkNode, linkMatrices[m] ) )
+				{
+					m_errorList << "Rigging: Cluster link differs from bind pose: " % QString( fbxLinkNode->GetName() );
+				}
 			}
-			mapConversions.append( mapConv );
+		}
 
-			dsBinding->setWeights( dsWeightMap );
-			FbxAMatrix fbxMatrix;
-			fbxCluster->GetTransformLinkMatrix( fbxMatrix );
-
-			DzMatrix3 dsMatrix;
-			dsMatrix[0][0] =  fbxMatrix[0][0];
-			dsMatrix[0][1] =  fbxMatrix[0][1];
-			dsMatrix[0][2] =  fbxMatrix[0][2];
-			dsMatrix[1][0] =  fbxMatrix[1][0];
-			dsMatrix[1][1] =  fbxMatrix[1][1];
-			dsMatrix[1][2] =  fbxMatrix[1][2];
-			dsMatrix[2][0] =  fbxMatrix[2][0];
-			dsMatrix[2][1] =  fbxMatrix[2][1];
-			dsMatrix[2][2] =  fbxMatrix[2][2];
-			dsMatrix[3][0] = -fbxMatrix[3][0];
-			dsMatrix[3][1] = -fbxMatrix[3][1];
-			dsMatrix[3][2] = -fbxMatrix[3][2];
-
-			DzVec3 skelOrigin = dsFigure->getOrigin();
-			DzVec3 origin = dsBone->getOrigin();
-			dsMatrix[3][0] += ( origin[0] - skelOrigin[0] );
-			dsMatrix[3][1] += ( origin[1] - skelOrigin[1] );
-			dsMatrix[3][2] += ( origin[2] - skelOrigin[2] );
-			dsBinding->setBindingMatrix( dsMatrix );
-			maps.append( dsWeightMap );
-		}
-
-		for ( int v = 0; v < numVertices; v++ )
+		QVector<DzMatrix3> bindingMatrices( numBound );
+		toBindingMatrices( linkMatrices.constData(), originOffsets.constData(), numBound, bindingMatrices.data() );
+
+		QVector<int> mapIndices( boundClusters.count(), -1 );
+		QVector<DzWeightMap*> dsWeightMaps;
+		QVector<unsigned short*> dsWeights;
+		for ( int m = 0; m < boundClusters.count(); m++ )
 		{
-			double sum = 0.0;
-			for ( int m = 0; m < mapConversions.count(); m++ )
+			if ( !influencing[m] )
 			{
-				sum += mapConversions[m].fbxWeights[v];
+				continue;
 			}
 
-			for ( int m = 0; m < mapConversions.count(); m++ )
+			DzBone* dsBone = boundBones[m];
+
+			DzBoneBinding* dsBinding = new DzBoneBinding();
+			dsBinding->setBone( dsBone );
+			dsSkin->addBoneBinding( dsBinding );
+
+			DzWeightMap* dsWeightMap  = new DzWeightMap( numVertices );
+			mapIndices[m] = dsWeights.count();
+			dsWeightMaps.append( dsWeightMap );
+			dsWeights.append( dsWeightMap->getWeights() );
+
+			dsBinding->setWeights( dsWeightMap );
+			dsBinding->setBindingMatrix( bindingMatrices[m] );
+		}
+
+		if ( pruneInfluences )
+		{
+			for ( int v = 0; v < numVertices; v++ )
 			{
-				mapConversions[m].dsWeights[v] = static_cast<unsigned short>( mapConversions[m].fbxWeights[v] / sum * DZ_USHORT_MAX );
+				for ( int k = skinWeights.begins[v]; k < skinWeights.ends[v]; k++ )
+				{
+					skinWeights.maps[k] = mapIndices[skinWeights.maps[k]];
+				}
 			}
 		}
 
-		DzWeightMap::normalizeMaps( maps );
+		// the rows are normalized exactly as they are quantized, so the maps
+		// do not need to be normalized again afterwards
+		QVector<SkinWeightRange> ranges;
+		for ( int v = 0; v < numVertices; v += c_skinWeightRangeSize )
+		{
+			ranges.append( SkinWeightRange( v, qMin( v + c_skinWeightRangeSize, numVertices ) ) );
+		}
+
+		QtConcurrent::blockingMap( ranges, QuantizeSkinWeights(
+			skinWeights.begins.constData(), skinWeights.ends.constData(),
+			skinWeights.maps.constData(), skinWeights.weights.constData(),
+			dsWeights.constData() ) );
+
+#if DZ_SDK_4_12_OR_GREATER
+		for ( int m = 0; m < dsWeightMaps.count(); m++ )
+		{
+			dsWeightMaps[m]->reduceWeightMemory();
+		}
+#endif
+
+		// a blend map is only created if any vertex has a blend weight
+		DzWeightMapPtr dsBlendWeights;
+		if ( skinWeights.hasBlendWeights )
+		{
+			dsBlendWeights = new DzWeightMap( numVertices, "Blend Weights" );
+			unsigned short* dsBlendWeightValues = dsBlendWeights->getWeights();
+			for ( int k = 0; k < skinWeights.blendVertices.count(); k++ )
+			{
+				dsBlendWeightValues[skinWeights.blendVertices[k]] = DZ_USHORT_MAX * skinWeights.blendWeights[k];
+			}
+
+#if DZ_SDK_4_12_OR_GREATER
+			dsBlendWeights->reduceWeightMemory();
+#endif
+		}
 
 		FbxSkin::EType fbxSkinningType = fbxSkin->GetSkinningType();
 
@@ -774,10 +1311,10 @@ void DzFbxImporter::fbxImportSkinning()
 #endif
 
 		if ( fbxSkinningType == FbxSkin::eBlend
-			&& skinning.blendWeights )
+			&& dsBlendWeights )
 		{
 #if DZ_SDK_4_12_OR_GREATER
-			dsSkin->setBlendMap( skinning.blendWeights );
+			dsSkin->setBlendMap( dsBlendWeights );
 			dsSkin->setBlendMode( DzSkinBinding::BlendLinearDualQuat );
 #else
 			// DzSkinBinding::setBlendMap() and DzSkinBinding::setBlendMode()
@@ -785,7 +1322,7 @@ void DzFbxImporter::fbxImportSkinning()
 			// call these methods.
 
 			im = QMetaObject::invokeMethod( dsSkin, "setBlendMap",
-				Q_ARG( DzWeightMap*, skinning.blendWeights.operator->() ) );
+				Q_ARG( DzWeightMap*, dsBlendWeights.operator->() ) );
 			assert( im );
 
 			im = QMetaObject::invokeMethod( dsSkin, "setBlendMode",
@@ -802,6 +1339,13 @@ void DzFbxImporter::fbxImport()
 {
 	fbxPickAnimation();
 
+	fbxPreImportPolygonSets();
+	fbxPreImportBindPoses();
+	preImportMorphFilter();
+
+	m_pbrMatFactory = dzApp->findClassFactory( "DzPbrMaterial" ); //or "DzUberIrayMaterial"
+	m_materialDataMap.clear();
+
 	m_root = new Node();
 	m_root->fbxNode = m_fbxScene->GetRootNode();
 
@@ -834,6 +1378,24 @@ void DzFbxImporter::fbxCleanup()
 	}
 
 	m_fbxManager = NULL;
+
+	m_textureReadAhead.cancel();
+	m_textureReadAhead.waitForFinished();
+	m_textureReadAhead = QFuture< QPair<QString, QString> >();
+	m_textureReadAheadMap.clear();
+
+	m_textureCache.clear();
+	m_textureProxyOriginals.clear();
+	m_textureFileIndex.clear();
+
+	m_polygonSetMap.clear();
+	m_bindPoseMap.clear();
+	m_importNodeMap.clear();
+	m_figureAncestorMap.clear();
+	m_originCache.clear();
+
+	m_morphIncludes.clear();
+	m_morphExcludes.clear();
 }
 
 /**
@@ -854,11 +1416,29 @@ DzError DzFbxImporter::read( const QString &filename, const DzFileIOSettings* im
 	// Properties
 	m_includeRotationLimits = options.getBoolValue( c_optIncRotationLimits, c_defaultIncludeRotationLimits );
 	m_includeAnimations = options.getBoolValue( c_optIncAnimations, c_defaultIncludeAnimations );
+	m_keyReductionTolerance = options.getFloatValue( c_optKeyReductionTolerance, c_defaultKeyReductionTolerance );
 	m_takeName = options.getStringValue( c_optTake, QString() );
 
 	// Geometry
 	m_includePolygonSets = options.getBoolValue( c_optIncPolygonSets, c_defaultIncludePolygonSets );
 	m_includePolygonGroups = options.getBoolValue( c_optIncPolygonGroups, c_defaultIncludePolygonGroups );
+	m_weldVertices = options.getBoolValue( c_optWeldVertices, c_defaultWeldVertices );
+	m_weldTolerance = qBound( c_minWeldTolerance,
+		options.getFloatValue( c_optWeldTolerance, c_defaultWeldTolerance ), c_maxWeldTolerance );
+
+	// Morphs
+	m_morphFilter = options.getStringValue( c_optMorphFilter, c_defaultMorphFilter );
+	m_morphQuantizeDeltas = options.getBoolValue( c_optMorphQuantizeDeltas, c_defaultMorphQuantizeDeltas );
+	m_morphShareDuplicates = options.getBoolValue( c_optMorphShareDuplicates, c_defaultMorphShareDuplicates );
+
+	// Skinning
+	m_minimalFollowerSkeletons = options.getBoolValue( c_optMinimalFollowerSkeletons, c_defaultMinimalFollowerSkeletons );
+	m_skinMaxInfluences = options.getIntValue( c_optSkinMaxInfluences, c_defaultSkinMaxInfluences );
+	m_skinMinWeight = options.getFloatValue( c_optSkinMinWeight, c_defaultSkinMinWeight );
+
+	// Textures
+	m_textureSearchPaths = options.getStringValue( c_optTextureSearchPaths, c_defaultTextureSearchPaths );
+	m_textureProxyMaxSize = options.getIntValue( c_optTextureProxyMaxSize, c_defaultTextureProxyMaxSize );
 
 	// Custom Data
 	m_studioNodeNamesLabels = options.getBoolValue( c_optStudioNodeNamesLabels, c_defaultStudioNodeNames );
@@ -874,13 +1454,19 @@ DzError DzFbxImporter::read( const QString &filename, const DzFileIOSettings* im
 	m_folder.cdUp();
 
 	fbxRead( filename );
+	if ( m_fbxReadSucceeded )
+	{
+		fbxReadAheadTextures();
+	}
 	fbxImport();
 	fbxCleanup();
 
+	// only the unique translated materials need to be checked
 	bool allTransparent = true;
-	for ( int i = 0; i < m_dsMaterials.size() && allTransparent; i++ )
+	QHash<FbxSurfaceMaterial*, MaterialData>::const_iterator matDataIt;
+	for ( matDataIt = m_materialDataMap.constBegin(); matDataIt != m_materialDataMap.constEnd() && allTransparent; ++matDataIt )
 	{
-		if ( m_dsMaterials[i]->getBaseOpacity() > 0.1 )
+		if ( matDataIt.value().opacityBase > 0.1 )
 		{
 			allTransparent = false;
 		}
@@ -894,6 +1480,8 @@ DzError DzFbxImporter::read( const QString &filename, const DzFileIOSettings* im
 		}
 	}
 
+	m_materialDataMap.clear();
+
 	return DZ_NO_ERROR;
 }
 
@@ -1066,6 +1654,17 @@ void DzFbxImporter::setTakeName( const QString &name )
 	m_takeName = name;
 }
 
+/**
+	@param tolerance	The largest error, as a fraction of the range of values
+						of an animation curve, that keys may be removed within;
+						or 0 to keep every key. A small absolute tolerance for
+						each kind of property applies when it is larger.
+**/
+void DzFbxImporter::setKeyReductionTolerance( double tolerance )
+{
+	m_keyReductionTolerance = tolerance;
+}
+
 /**
 **/
 void DzFbxImporter::setIncludePolygonSets( bool enable )
@@ -1080,6 +1679,106 @@ void DzFbxImporter::setIncludePolygonGroups( bool enable )
 	m_includePolygonGroups = enable;
 }
 
+/**
+**/
+void DzFbxImporter::setWeldVertices( bool enable )
+{
+	m_weldVertices = enable;
+}
+
+/**
+	@param tolerance	The distance within which control points are welded;
+						limited to a range that cannot collapse whole polygons
+						of a typically scaled mesh.
+**/
+void DzFbxImporter::setWeldTolerance( double tolerance )
+{
+	m_weldTolerance = qBound( c_minWeldTolerance, tolerance, c_maxWeldTolerance );
+}
+
+/**
+	@param enable	If true, skeletons that follow another skeleton only
+					receive the bones that their skin is bound to, and the
+					bones between them and the skeleton; otherwise they
+					receive a copy of the whole bone hierarchy.
+**/
+void DzFbxImporter::setMinimalFollowerSkeletons( bool enable )
+{
+	m_minimalFollowerSkeletons = enable;
+}
+
+/**
+	@param filter	A semicolon separated list of wildcard patterns that select
+					the blend shape channels to import by name. A pattern
+					prefixed with "-" excludes the channels it matches, and an
+					entry prefixed with "@" names a file of patterns, one per
+					line. If there are no include patterns, every channel that
+					is not excluded is imported.
+**/
+void DzFbxImporter::setMorphFilter( const QString &filter )
+{
+	m_morphFilter = filter;
+}
+
+/**
+	@param enable	If true, morph deltas are rounded to a grid with a step of
+					1/32767 of the extent of the mesh, shared by every channel.
+					The deltas are still stored as floats; deltas that round to
+					zero are dropped, and near-identical channels can be shared.
+**/
+void DzFbxImporter::setMorphQuantizeDeltas( bool enable )
+{
+	m_morphQuantizeDeltas = enable;
+}
+
+/**
+	@param enable	If true, a channel with the same deltas as an earlier one
+					drives the morph of that channel, instead of storing the
+					deltas again.
+**/
+void DzFbxImporter::setMorphShareDuplicates( bool enable )
+{
+	m_morphShareDuplicates = enable;
+}
+
+/**
+	@param maxInfluences	The maximum number of bones that influence a vertex,
+							or 0 for no limit.
+**/
+void DzFbxImporter::setSkinMaxInfluences( int maxInfluences )
+{
+	m_skinMaxInfluences = maxInfluences;
+}
+
+/**
+	@param minWeight	The fraction of the total weight of a vertex that an
+						influence must have to be kept, or 0 to keep all.
+**/
+void DzFbxImporter::setSkinMinWeight( double minWeight )
+{
+	m_skinMinWeight = minWeight;
+}
+
+/**
+	@param paths	A semicolon separated list of folders that are searched,
+					recursively, for texture files that cannot be found at
+					the path stored in the FBX file.
+**/
+void DzFbxImporter::setTextureSearchPaths( const QString &paths )
+{
+	m_textureSearchPaths = paths;
+}
+
+/**
+	@param maxSize	The largest width or height, in pixels, that textures are
+					loaded at; larger textures are replaced by downscaled
+					proxies. A value of 0 loads all textures at full size.
+**/
+void DzFbxImporter::setTextureProxyMaxSize( int maxSize )
+{
+	m_textureProxyMaxSize = maxSize;
+}
+
 /**
 **/
 void DzFbxImporter::setStudioNodeNamesLabels( bool enable )
@@ -1116,6 +1815,16 @@ QStringList DzFbxImporter::getErrorList() const
 }
 
 /**
+	Creates the bones of a skeleton that follows another, from the bones of
+	the skeleton it follows. By default the whole bone hierarchy is created.
+	If minimal follower skeletons are enabled, only the bones that the
+	clusters of the skin are linked to, and the bones between them and the
+	skeleton, are created.
+
+	@param dsBaseSkeleton	The skeleton to follow. This must be the skeleton
+							that was imported for the linked nodes, not
+							another follower of it, since a minimal follower
+							lacks the bones that other skins may need.
 **/
 void DzFbxImporter::replicateSkeleton( DzSkeleton* dsBaseSkeleton, const Skinning &skinning )
 {
@@ -1126,11 +1835,39 @@ void DzFbxImporter::replicateSkeleton( DzSkeleton* dsBaseSkeleton, const Skinnin
 		return;
 	}
 
-	const Node* baseNode = m_root->find( dsBaseSkeleton );
+	const Node* baseNode = m_importNodeMap.value( dsBaseSkeleton );
+	if ( !baseNode )
+	{
+		return;
+	}
+
+	QSet<FbxNode*> linkedBones;
+	if ( m_minimalFollowerSkeletons )
+	{
+		const FbxSkin* fbxSkin = skinning.fbxSkin;
+		for ( int i = 0, n = fbxSkin->GetClusterCount(); i < n; i++ )
+		{
+			FbxNode* fbxBone = fbxSkin->GetCluster( i )->GetLink();
+			while ( fbxBone
+				&& fbxBone != baseNode->fbxNode
+				&& !linkedBones.contains( fbxBone ) )
+			{
+				linkedBones.insert( fbxBone );
+				fbxBone = fbxBone->GetParent();
+			}
+		}
+	}
+
+	const QSet<FbxNode*>* filter = m_minimalFollowerSkeletons ? &linkedBones : NULL;
 
 	for ( int i = 0, n = baseNode->children.count(); i < n; i++ )
 	{
 		const Node* baseChild = baseNode->children.at( i );
+		if ( filter && !filter->contains( baseChild->fbxNode ) )
+		{
+			continue;
+		}
+
 		const FbxNodeAttribute* fbxBaseNodeAttr = baseChild->fbxNode->GetNodeAttribute();
 		if ( fbxBaseNodeAttr && fbxBaseNodeAttr->GetAttributeType() == FbxNodeAttribute::eMesh )
 		{
@@ -1142,7 +1879,7 @@ void DzFbxImporter::replicateSkeleton( DzSkeleton* dsBaseSkeleton, const Skinnin
 		child->fbxNode = baseChild->fbxNode;
 		child->dsParent = node->dsNode;
 
-		fbxImportGraph( child );
+		fbxImportGraph( child, filter );
 	}
 
 	dsSkeleton->setFollowTarget( dsBaseSkeleton );
@@ -1465,12 +2202,15 @@ void DzFbxImporter::fbxPreImportGraph( FbxNode* fbxNode )
 			const int numSkins = fbxMesh->GetDeformerCount( FbxDeformer::eSkin );
 			for ( int i = 0; i < numSkins; i++ )
 			{
-				// skinning weights must be linked to a bone
+				// skinning weights must be linked to a bone; the link
+				// matrices are checked against the bind pose by
+				// fbxImportSkinning()
 
 				FbxSkin* fbxSkin = FbxCast<FbxSkin>( fbxMesh->GetDeformer( i ) );
 				for ( int j = 0, m = fbxSkin->GetClusterCount(); j < m; j++ )
 				{
-					FbxNode* fbxClusterNode = fbxSkin->GetCluster( j )->GetLink();
+					FbxCluster* fbxCluster = fbxSkin->GetCluster( j );
+					FbxNode* fbxClusterNode = fbxCluster->GetLink();
 					if ( fbxClusterNode && fbxClusterNode->GetSkeleton() )
 					{
 						continue;
@@ -1522,6 +2262,7 @@ void DzFbxImporter::fbxPreImportGraph( FbxNode* fbxNode )
 void DzFbxImporter::fbxPreImport()
 {
 	fbxPreImportAnimationStack();
+	fbxPreImportBindPoses();
 
 	FbxNode* fbxRootNode = m_fbxScene->GetRootNode();
 	for ( int i = 0, n = fbxRootNode->GetChildCount(); i < n; i++ )
@@ -1532,7 +2273,7 @@ void DzFbxImporter::fbxPreImport()
 
 /**
 **/
-void DzFbxImporter::fbxImportGraph( Node* node )
+void DzFbxImporter::fbxImportGraph( Node* node, const QSet<FbxNode*>* filter )
 {
 	if ( node == m_root )
 	{
@@ -1646,6 +2387,10 @@ void DzFbxImporter::fbxImportGraph( Node* node )
 	if ( node->dsNode )
 	{
 		m_nodeMap[node->fbxNode] = node->dsNode;
+		m_importNodeMap.insert( node->dsNode, node );
+
+		DzFigure* dsParentFigure = qobject_cast<DzFigure*>( node->dsParent );
+		m_figureAncestorMap.insert( node->dsNode, dsParentFigure ? dsParentFigure : m_figureAncestorMap.value( node->dsParent ) );
 
 		QString nodeName( node->fbxNode->GetName() );
 #if FBXSDK_VERSION_MAJOR >= 2016
@@ -1695,26 +2440,15 @@ void DzFbxImporter::fbxImportGraph( Node* node )
 
 		if ( rotationOffset.SquareLength() == 0.0 )
 		{
-			bool found = false;
 			FbxMatrix fbxMatrix;
 
-			for ( int i = 0; i < m_fbxScene->GetPoseCount(); i++ )
+			// the last bind pose that references the node is used
+			QMultiHash<FbxNode*, QPair<FbxPose*, int> >::const_iterator bindPoseIt = m_bindPoseMap.constFind( node->fbxNode );
+			if ( bindPoseIt != m_bindPoseMap.constEnd() )
 			{
-				const FbxPose* pose = m_fbxScene->GetPose( i );
-				if ( pose->IsBindPose() )
-				{
-					for ( int j = 0; j < pose->GetCount(); j++ )
-					{
-						if ( pose->GetNode( j ) == node->fbxNode )
-						{
-							found = true;
-							fbxMatrix = pose->GetMatrix( j );
-						}
-					}
-				}
+				fbxMatrix = bindPoseIt.value().first->GetMatrix( bindPoseIt.value().second );
 			}
-
-			if ( !found )
+			else
 			{
 				fbxMatrix = node->fbxNode->EvaluateGlobalTransform();
 			}
@@ -1751,15 +2485,21 @@ void DzFbxImporter::fbxImportGraph( Node* node )
 
 		for ( int i = 0; i < node->fbxNode->GetChildCount(); i++ )
 		{
+			FbxNode* fbxChild = node->fbxNode->GetChild( i );
+			if ( filter && !filter->contains( fbxChild ) )
+			{
+				continue;
+			}
+
 			Node* child = new Node();
 			child->setParent( node );
 			child->dsParent = node->dsNode;
-			child->fbxNode = node->fbxNode->GetChild( i );
+			child->fbxNode = fbxChild;
 		}
 
 		for ( int i = 0; i < node->children.count(); i++ )
 		{
-			fbxImportGraph( node->children[i] );
+			fbxImportGraph( node->children[i], filter );
 		}
 
 		DzVec3 endPoint = node->dsNode->getOrigin();
@@ -1834,17 +2574,17 @@ void DzFbxImporter::fbxImportAnimation( Node* node )
 
 		if ( m_fbxAnimLayer && !node->collapseTranslation )
 		{
-			applyFbxCurve( node->fbxNode->LclTranslation.GetCurve( m_fbxAnimLayer, FBXSDK_CURVENODE_COMPONENT_X ), node->dsNode->getXPosControl() );
-			applyFbxCurve( node->fbxNode->LclTranslation.GetCurve( m_fbxAnimLayer, FBXSDK_CURVENODE_COMPONENT_Y ), node->dsNode->getYPosControl() );
-			applyFbxCurve( node->fbxNode->LclTranslation.GetCurve( m_fbxAnimLayer, FBXSDK_CURVENODE_COMPONENT_Z ), node->dsNode->getZPosControl() );
+			applyFbxCurve( node->fbxNode->LclTranslation.GetCurve( m_fbxAnimLayer, FBXSDK_CURVENODE_COMPONENT_X ), node->dsNode->getXPosControl(), c_minTranslationKeyTolerance );
+			applyFbxCurve( node->fbxNode->LclTranslation.GetCurve( m_fbxAnimLayer, FBXSDK_CURVENODE_COMPONENT_Y ), node->dsNode->getYPosControl(), c_minTranslationKeyTolerance );
+			applyFbxCurve( node->fbxNode->LclTranslation.GetCurve( m_fbxAnimLayer, FBXSDK_CURVENODE_COMPONENT_Z ), node->dsNode->getZPosControl(), c_minTranslationKeyTolerance );
 
-			applyFbxCurve( node->fbxNode->LclRotation.GetCurve( m_fbxAnimLayer, FBXSDK_CURVENODE_COMPONENT_X ), node->dsNode->getXRotControl() );
-			applyFbxCurve( node->fbxNode->LclRotation.GetCurve( m_fbxAnimLayer, FBXSDK_CURVENODE_COMPONENT_Y ), node->dsNode->getYRotControl() );
-			applyFbxCurve( node->fbxNode->LclRotation.GetCurve( m_fbxAnimLayer, FBXSDK_CURVENODE_COMPONENT_Z ), node->dsNode->getZRotControl() );
+			applyFbxCurve( node->fbxNode->LclRotation.GetCurve( m_fbxAnimLayer, FBXSDK_CURVENODE_COMPONENT_X ), node->dsNode->getXRotControl(), c_minRotationKeyTolerance );
+			applyFbxCurve( node->fbxNode->LclRotation.GetCurve( m_fbxAnimLayer, FBXSDK_CURVENODE_COMPONENT_Y ), node->dsNode->getYRotControl(), c_minRotationKeyTolerance );
+			applyFbxCurve( node->fbxNode->LclRotation.GetCurve( m_fbxAnimLayer, FBXSDK_CURVENODE_COMPONENT_Z ), node->dsNode->getZRotControl(), c_minRotationKeyTolerance );
 
-			applyFbxCurve( node->fbxNode->LclScaling.GetCurve( m_fbxAnimLayer, FBXSDK_CURVENODE_COMPONENT_X ), node->dsNode->getXScaleControl() );
-			applyFbxCurve( node->fbxNode->LclScaling.GetCurve( m_fbxAnimLayer, FBXSDK_CURVENODE_COMPONENT_Y ), node->dsNode->getYScaleControl() );
-			applyFbxCurve( node->fbxNode->LclScaling.GetCurve( m_fbxAnimLayer, FBXSDK_CURVENODE_COMPONENT_Z ), node->dsNode->getZScaleControl() );
+			applyFbxCurve( node->fbxNode->LclScaling.GetCurve( m_fbxAnimLayer, FBXSDK_CURVENODE_COMPONENT_X ), node->dsNode->getXScaleControl(), c_minScaleKeyTolerance );
+			applyFbxCurve( node->fbxNode->LclScaling.GetCurve( m_fbxAnimLayer, FBXSDK_CURVENODE_COMPONENT_Y ), node->dsNode->getYScaleControl(), c_minScaleKeyTolerance );
+			applyFbxCurve( node->fbxNode->LclScaling.GetCurve( m_fbxAnimLayer, FBXSDK_CURVENODE_COMPONENT_Z ), node->dsNode->getZScaleControl(), c_minScaleKeyTolerance );
 		}
 
 
@@ -1908,233 +2648,1441 @@ static QColor toQColor( FbxPropertyT<FbxDouble3> fbxValue )
 	return clr;
 }
 
+namespace
+{
+
+const QString c_embeddedMediaManifest( ".manifest" );
+
 /**
+	@return	The folder that embedded media is extracted to.
 **/
-DzTexture* DzFbxImporter::toTexture( FbxProperty fbxProperty )
+QString getEmbeddedMediaCachePath()
 {
-	for ( int i = 0; i < fbxProperty.GetSrcObjectCount<FbxFileTexture>(); ++i )
-	{
-		const FbxFileTexture* fbxFileTexture = fbxProperty.GetSrcObject<FbxFileTexture>( i );
-		const DzImageMgr* imgMgr = dzApp->getImageMgr();
-		DzTexture* dsTexture = imgMgr->getImage( fbxFileTexture->GetFileName() );
-		if ( !dsTexture )
-		{
-			dsTexture = imgMgr->getImage( m_folder.filePath( fbxFileTexture->GetFileName() ) );
-		}
+	return QDir( dzApp->getAppDataPath() ).filePath( "FBX Importer/Embedded Media" );
+}
 
-		return dsTexture;
+/**
+	@return	A hex encoded SHA-1 of the absolute path, size and modification
+			time of a file, which identifies a version of the file without
+			reading it; empty if the file does not exist.
+**/
+QString fileVersionKey( const QString &filePath )
+{
+	const QFileInfo fileInfo( filePath );
+	if ( !fileInfo.isFile() )
+	{
+		return QString();
 	}
 
-	return 0;
+	const QString key = QString( "%1|%2|%3" )
+		.arg( fileInfo.absoluteFilePath() )
+		.arg( fileInfo.size() )
+		.arg( fileInfo.lastModified().toTime_t() );
+	return QString::fromLatin1( QCryptographicHash::hash( key.toUtf8(), QCryptographicHash::Sha1 ).toHex() );
 }
 
 /**
+	@return	A hex encoded SHA-1 of the contents of a file, or an empty string
+			if the file could not be read.
 **/
-void DzFbxImporter::fbxImportVertices( int numVertices, FbxVector4* fbxVertices, DzFacetMesh* dsMesh, DzVec3 offset )
+QString hashFileContents( const QString &filePath )
 {
-	DzPnt3* dsVertices = dsMesh->setVertexArray( numVertices );
-	for ( int i = 0; i < numVertices; i++ )
+	QFile file( filePath );
+	if ( !file.open( QIODevice::ReadOnly ) )
+	{
+		return QString();
+	}
+
+	QCryptographicHash hash( QCryptographicHash::Sha1 );
+
+	const qint64 chunkSize = 1 << 20;
+	QByteArray chunk;
+	do
 	{
-		dsVertices[i][0] = fbxVertices[i][0] + offset[0];
-		dsVertices[i][1] = fbxVertices[i][1] + offset[1];
-		dsVertices[i][2] = fbxVertices[i][2] + offset[2];
+		chunk = file.read( chunkSize );
+		hash.addData( chunk );
 	}
+	while ( !chunk.isEmpty() );
+
+	return QString::fromLatin1( hash.result().toHex() );
 }
 
 /**
+	Removes a folder and everything in it. Symbolic links are removed, not
+	followed.
 **/
-void DzFbxImporter::fbxImportUVs( FbxMesh* fbxMesh, DzFacetMesh* dsMesh )
+void removeFolder( const QString &folderPath )
 {
-	for ( int i = 0, n = fbxMesh->GetElementUVCount(); i < n; i++ )
+	QStringList subFolderPaths;
+	QDirIterator dirIt( folderPath, QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot,
+		QDirIterator::Subdirectories );
+	while ( dirIt.hasNext() )
 	{
-		const FbxGeometryElementUV* fbxGeomUv = fbxMesh->GetElementUV( i );
-		const int numUvs = fbxGeomUv->GetDirectArray().GetCount();
-
-		DzMap* dsUvMap = dsMesh->getUVs();
-		dsUvMap->setNumValues( numUvs );
-		DzPnt2* dsUVs = dsUvMap->getPnt2ArrayPtr();
-
-		for ( int j = 0; j < numUvs; j++ )
+		const QString path = dirIt.next();
+		const QFileInfo fileInfo = dirIt.fileInfo();
+		if ( fileInfo.isDir() && !fileInfo.isSymLink() )
 		{
-			const FbxVector2 fbxUv = fbxGeomUv->GetDirectArray().GetAt( j );
-			dsUVs[j][0] = fbxUv[0];
-			dsUVs[j][1] = fbxUv[1];
+			// folders are listed before their contents, so they are
+			// prepended to be removed after them
+			subFolderPaths.prepend( path );
 		}
+		else
+		{
+			QFile::remove( path );
+		}
+	}
 
-		// only do the first
-		break;
+	QDir dir;
+	for ( int i = 0; i < subFolderPaths.count(); i++ )
+	{
+		dir.rmdir( subFolderPaths[i] );
 	}
+
+	dir.rmdir( folderPath );
 }
 
 /**
+	@return	The files in a folder and its sub-folders, relative to the folder.
 **/
-void DzFbxImporter::fbxImportSubdVertexWeights( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, bool &enableSubd )
+QStringList listFolderFiles( const QString &folderPath )
 {
-	for ( int i = 0, n = fbxMesh->GetElementVertexCreaseCount(); i < n; i++ )
+	const QDir folder( folderPath );
+
+	QStringList relPaths;
+	QDirIterator dirIt( folderPath, QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot, QDirIterator::Subdirectories );
+	while ( dirIt.hasNext() )
 	{
-		const FbxGeometryElementCrease* fbxSubdVertexCrease = fbxMesh->GetElementVertexCrease( i );
-		for ( int j = 0, m = fbxSubdVertexCrease->GetDirectArray().GetCount(); j < m; j++ )
-		{
-			const double weight = fbxSubdVertexCrease->GetDirectArray().GetAt( j );
-			if ( weight > 0 )
-			{
-				enableSubd = true;
+		relPaths.append( folder.relativeFilePath( dirIt.next() ) );
+	}
 
-#if DZ_SDK_4_12_OR_GREATER
-				dsMesh->setVertexWeight( j, weight );
-#else
-				// DzFacetMesh::setVertexWeight() is not in the 4.5 SDK, so we
-				// attempt to use the meta-object to call the method.
+	return relPaths;
+}
 
-				bool im = QMetaObject::invokeMethod( dsMesh, "setVertexWeight",
-					Q_ARG( int, j ), Q_ARG( int, weight ) );
-				assert( im );
-#endif
-			}
+/**
+	Moves the files in a folder into another, replacing files at the same
+	relative paths. The source folder is removed if every file was moved.
+
+	@return	true if every file was moved.
+**/
+bool mergeFolderInto( const QString &srcPath, const QString &dstPath )
+{
+	const QDir srcFolder( srcPath );
+	const QDir dstFolder( dstPath );
+
+	bool moved = true;
+	const QStringList relPaths = listFolderFiles( srcPath );
+	for ( int i = 0; i < relPaths.count(); i++ )
+	{
+		const QString dstFilePath = dstFolder.filePath( relPaths[i] );
+		QDir().mkpath( QFileInfo( dstFilePath ).absolutePath() );
+		QFile::remove( dstFilePath );
+		if ( !QFile::rename( srcFolder.filePath( relPaths[i] ), dstFilePath ) )
+		{
+			moved = false;
 		}
+	}
 
-		// only do the first
-		break;
+	if ( moved )
+	{
+		removeFolder( srcPath );
 	}
+
+	return moved;
 }
 
 /**
+	@return	The content key that a previous import recorded for a version of
+			a file, or an empty string if there is none.
 **/
-void DzFbxImporter::fbxImportMaterials( FbxNode* fbxNode, FbxMesh* fbxMesh, DzFacetMesh* dsMesh, DzFacetShape* dsShape, bool &matsAllSame )
+QString readEmbeddedMediaContentKey( const QString &cachePath, const QString &versionKey )
 {
-	for ( int i = 0, n = fbxNode->GetMaterialCount(); i < n; i++ )
+	QFile keyFile( QDir( cachePath ).filePath( versionKey + ".key" ) );
+	if ( !keyFile.open( QIODevice::ReadOnly | QIODevice::Text ) )
 	{
-		QColor diffuseColor = Qt::white;
-		DzTexturePtr diffuseMap = NULL;
+		return QString();
+	}
 
-		float diffuseFactor = 1.0f;
+	return QString::fromLatin1( keyFile.readAll() ).trimmed();
+}
 
-		float opacityBase = 1.0f;
-		DzTexturePtr opacityMap = NULL;
+/**
+	Records the content key of a version of a file, so that subsequent
+	imports of the same version can find its media without hashing it.
+**/
+void writeEmbeddedMediaContentKey( const QString &cachePath, const QString &versionKey, const QString &contentKey )
+{
+	QFile keyFile( QDir( cachePath ).filePath( versionKey + ".key" ) );
+	if ( keyFile.open( QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text ) )
+	{
+		keyFile.write( contentKey.toLatin1() );
+	}
+}
 
-		QColor ambientColor = Qt::black;
-		DzTexturePtr ambientMap = NULL;
+/**
+	@return	true if a previous extraction of embedded media to the folder was
+			completed and every file it extracted still exists.
+**/
+bool isEmbeddedMediaManifestValid( const QString &folderPath )
+{
+	const QDir folder( folderPath );
 
-		float ambientFactor = 1.0f;
+	QFile manifest( folder.filePath( c_embeddedMediaManifest ) );
+	if ( !manifest.open( QIODevice::ReadOnly | QIODevice::Text ) )
+	{
+		return false;
+	}
 
-		QColor specularColor = Qt::white;
-		DzTexturePtr specularMap = NULL;
+	QTextStream stream( &manifest );
+	stream.setCodec( "UTF-8" );
+	while ( !stream.atEnd() )
+	{
+		const QString relPath = stream.readLine();
+		if ( !relPath.isEmpty()
+			&& !QFileInfo( folder.filePath( relPath ) ).isFile() )
+		{
+			return false;
+		}
+	}
 
-		float specularFactor = 1.0f;
+	return true;
+}
 
-		float shininess = 1.0f;
-		DzTexturePtr shininessMap = NULL;
+/**
+	Records the files in the folder, so that extraction to it can be skipped
+	by subsequent imports.
+**/
+void writeEmbeddedMediaManifestFile( const QString &folderPath )
+{
+	QStringList relPaths = listFolderFiles( folderPath );
+	relPaths.removeAll( c_embeddedMediaManifest );
 
-		float reflectionFactor = 1.0f;
-		DzTexturePtr reflectionMap = NULL;
+	QFile manifest( QDir( folderPath ).filePath( c_embeddedMediaManifest ) );
+	if ( !manifest.open( QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text ) )
+	{
+		return;
+	}
 
-		float roughness = 0.1f;
-		float metallicity = 1.0f;
+	QTextStream stream( &manifest );
+	stream.setCodec( "UTF-8" );
+	for ( int i = 0; i < relPaths.count(); i++ )
+	{
+		stream << relPaths[i] << "\n";
+	}
+}
 
-		FbxSurfaceMaterial* fbxMaterial = fbxNode->GetMaterial( i );
-		DzMaterialPtr dsMaterial = NULL;
+} //namespace
 
-		const DzClassFactory* pbrMatFactory = dzApp->findClassFactory( "DzPbrMaterial" ); //or "DzUberIrayMaterial"
-		if ( QObject* pbrMatInstance = pbrMatFactory ? pbrMatFactory->createInstance() : NULL )
-		{
-			dsMaterial = qobject_cast<DzMaterial*>( pbrMatInstance );
-		}
-		else
-		{
-			dsMaterial = new DzDefaultMaterial();
-		}
+/**
+	Sets up the extraction of media (e.g., textures) embedded in the FBX file.
+	Rather than being extracted to a .fbm folder next to the file on every
+	import, embedded media is kept in a cache folder named by a hash of the
+	contents of the file. A key file, named by a hash of the path, size and
+	modification time of the file, records which cache folder a version of
+	the file uses, so that the contents are only hashed once. If that folder
+	holds a completed extraction whose files still exist, extraction is
+	disabled and textures are resolved to the cached files. Otherwise, media
+	is extracted to a staging folder, which fbxFinishEmbeddedMedia() moves
+	into the cache once the import succeeds.
+
+	The cache is never pruned; scenes saved after an import reference the
+	files in it.
+
+	@param filename			The path of the file being imported.
+	@param fbxImporter		The importer the file is read with.
+	@param fbxIoSettings	The settings the file is read with.
+
+	@return	true if embedded media will be extracted to the staging folder, in
+			which case fbxFinishEmbeddedMedia() should be called once the
+			import succeeds.
+
+	@sa fbxIndexTextureFolders()
+**/
+bool DzFbxImporter::fbxPrepareEmbeddedMedia( const QString &filename, FbxImporter* fbxImporter, FbxIOSettings* fbxIoSettings )
+{
+	const QString versionKey = fileVersionKey( filename );
+	if ( versionKey.isEmpty() )
+	{
+		return false;
+	}
 
-		DzDefaultMaterial* dsDefMaterial = qobject_cast<DzDefaultMaterial*>( dsMaterial );
+	const QDir cacheFolder( getEmbeddedMediaCachePath() );
 
-		FbxSurfacePhong* fbxPhong = FbxCast<FbxSurfacePhong>( fbxMaterial );
-		if ( fbxPhong )
+	const QString contentKey = readEmbeddedMediaContentKey( cacheFolder.path(), versionKey );
+	if ( !contentKey.isEmpty() )
+	{
+		const QString contentPath = cacheFolder.filePath( contentKey );
+		if ( isEmbeddedMediaManifestValid( contentPath )
+			&& fbxImporter->SetEmbeddingExtractionFolder( QDir::toNativeSeparators( contentPath ).toUtf8().data() ) )
 		{
-			diffuseColor = toQColor( fbxPhong->Diffuse );
-			diffuseMap = toTexture( fbxPhong->Diffuse );
+			m_embeddedMediaPath = contentPath;
+			fbxIoSettings->SetBoolProp( IMP_FBX_EXTRACT_EMBEDDED_DATA, false );
+			return false;
+		}
+	}
 
-			// Maya and Max want transparency in the color
-			opacityBase = 1 - (fbxPhong->TransparentColor.Get()[0] + fbxPhong->TransparentColor.Get()[1] + fbxPhong->TransparentColor.Get()[2]) / 3;
-			opacityMap = toTexture( fbxPhong->TransparentColor );
+	const QString stagingPath = cacheFolder.filePath( versionKey + ".staging" );
+	removeFolder( stagingPath );
+	if ( !QDir().mkpath( stagingPath )
+		|| !fbxImporter->SetEmbeddingExtractionFolder( QDir::toNativeSeparators( stagingPath ).toUtf8().data() ) )
+	{
+		return false;
+	}
 
-			if ( dsDefMaterial )
-			{
-				diffuseFactor = fbxPhong->DiffuseFactor.Get();
+	m_embeddedMediaPath = stagingPath;
 
-				ambientColor = toQColor( fbxPhong->Ambient );
-				ambientMap = toTexture( fbxPhong->Ambient );
+	fbxIoSettings->SetBoolProp( IMP_FBX_EXTRACT_EMBEDDED_DATA, true );
+	return true;
+}
 
-				ambientFactor = fbxPhong->AmbientFactor.Get();
+/**
+	Moves embedded media extracted by a successful import from the staging
+	folder into the cache folder named by a hash of the contents of the file,
+	and records that folder for the version of the file. If the cache folder
+	already holds a completed extraction, the staged files are discarded. If
+	nothing was extracted, the staging folder is removed.
 
-				specularColor = toQColor( fbxPhong->Specular );
-				specularMap = toTexture( fbxPhong->Specular );
+	Texture references still point at the staging folder; they are resolved
+	to the cache folder through the texture file index.
 
-				specularFactor = fbxPhong->SpecularFactor.Get();
+	@param filename	The path of the file that was imported.
 
-				shininess = fbxPhong->Shininess.Get();
-				shininessMap = toTexture( fbxPhong->Shininess );
+	@sa fbxPrepareEmbeddedMedia()
+	@sa fbxIndexTextureFolders()
+**/
+void DzFbxImporter::fbxFinishEmbeddedMedia( const QString &filename )
+{
+	const QString stagingPath = m_embeddedMediaPath;
+	if ( listFolderFiles( stagingPath ).isEmpty() )
+	{
+		removeFolder( stagingPath );
+		return;
+	}
 
-				reflectionFactor = fbxPhong->ReflectionFactor.Get();
-				reflectionMap = toTexture( fbxPhong->ReflectionFactor );
-			}
-			else //DzPbrMaterial or DzUberIrayMaterial
+	const QString contentKey = hashFileContents( filename );
+	if ( contentKey.isEmpty() )
+	{
+		return;
+	}
+
+	const QDir cacheFolder( getEmbeddedMediaCachePath() );
+	const QString contentPath = cacheFolder.filePath( contentKey );
+	if ( isEmbeddedMediaManifestValid( contentPath ) )
+	{
+		removeFolder( stagingPath );
+		m_embeddedMediaPath = contentPath;
+	}
+	else if ( mergeFolderInto( stagingPath, contentPath ) )
+	{
+		writeEmbeddedMediaManifestFile( contentPath );
+		m_embeddedMediaPath = contentPath;
+	}
+	else
+	{
+		// the extraction is not recorded, so the next import repeats it
+		return;
+	}
+
+	writeEmbeddedMediaContentKey( cacheFolder.path(), fileVersionKey( filename ), contentKey );
+}
+
+namespace
+{
+
+/**
+	@return	The key used to look up a texture file name in the texture file
+			index; the lower case file name without the path. Both separators
+			are handled, since paths are commonly authored on another platform.
+**/
+QString textureIndexKey( const QString &fileName )
+{
+	const int sepIdx = qMax( fileName.lastIndexOf( '/' ), fileName.lastIndexOf( '\\' ) );
+	return fileName.mid( sepIdx + 1 ).toLower();
+}
+
+/**
+	Adds the files in a folder to the texture file index. Every file with a
+	given name is kept, so that references can be matched by their path;
+	folders should be added in order of priority, which breaks ties.
+**/
+void indexTextureFolder( const QString &folderPath, bool recursive, QMultiHash<QString, QString> &fileIndex )
+{
+	if ( folderPath.isEmpty() )
+	{
+		return;
+	}
+
+	QDirIterator dirIt( folderPath, QDir::Files | QDir::NoDotAndDotDot,
+		recursive ? QDirIterator::Subdirectories | QDirIterator::FollowSymlinks : QDirIterator::NoIteratorFlags );
+	while ( dirIt.hasNext() )
+	{
+		const QString filePath = dirIt.next();
+		const QString key = dirIt.fileName().toLower();
+		if ( !fileIndex.contains( key, filePath ) )
+		{
+			fileIndex.insert( key, filePath );
+		}
+	}
+}
+
+/**
+	@return	The number of trailing path components that two paths have in
+			common, compared case insensitively. Both separators are handled.
+**/
+int matchingPathSuffixLength( const QString &path1, const QString &path2 )
+{
+	const QRegExp separators( "[/\\\\]" );
+	const QStringList parts1 = path1.split( separators, QString::SkipEmptyParts );
+	const QStringList parts2 = path2.split( separators, QString::SkipEmptyParts );
+
+	int length = 0;
+	for ( int i = parts1.count() - 1, j = parts2.count() - 1; i >= 0 && j >= 0; i--, j-- )
+	{
+		if ( parts1[i].compare( parts2[j], Qt::CaseInsensitive ) != 0 )
+		{
+			break;
+		}
+
+		length++;
+	}
+
+	return length;
+}
+
+/**
+	@param fileIndex	The texture file index.
+	@param fileName		The texture file name to look up.
+	@param isAmbiguous	Set to true if more than one indexed file has the
+						longest path suffix in common with the name.
+
+	@return	The indexed file that best matches a texture file name; the one
+			with the longest path suffix in common with the name, or the one
+			indexed first if there is a tie. Empty if the name is not indexed.
+**/
+QString findIndexedTextureFile( const QMultiHash<QString, QString> &fileIndex, const QString &fileName, bool &isAmbiguous )
+{
+	// values are listed from the most recently inserted, so they are walked
+	// in reverse for ties to go to the folder with the highest priority
+	const QStringList candidates = fileIndex.values( textureIndexKey( fileName ) );
+
+	QString bestPath;
+	int bestLength = 0;
+	isAmbiguous = false;
+	for ( int i = candidates.count() - 1; i >= 0; i-- )
+	{
+		const int length = matchingPathSuffixLength( fileName, candidates[i] );
+		if ( length > bestLength )
+		{
+			bestLength = length;
+			bestPath = candidates[i];
+			isAmbiguous = false;
+		}
+		else if ( length == bestLength )
+		{
+			isAmbiguous = true;
+		}
+	}
+
+	return bestPath;
+}
+
+/**
+	@return	The image reduced to half its width and height with a 2x2 box
+			filter. The image must be in a 32-bit per pixel format that is
+			premultiplied, or opaque, so that transparent pixels do not bleed
+			color.
+**/
+QImage halveImage( const QImage &image )
+{
+	const int width = image.width() / 2;
+	const int height = image.height() / 2;
+
+	QImage result( width, height, image.format() );
+	for ( int y = 0; y < height; y++ )
+	{
+		const uchar* row0 = image.constScanLine( y * 2 );
+		const uchar* row1 = image.constScanLine( y * 2 + 1 );
+		uchar* dst = result.scanLine( y );
+
+		// channels are averaged independently, so the loop is written over
+		// bytes, which lets the compiler vectorize it
+		for ( int x = 0, n = width * 4; x < n; x++ )
+		{
+			const int src = ( x & ~3 ) * 2 + ( x & 3 );
+			dst[x] = uchar( ( row0[src] + row0[src + 4] + row1[src] + row1[src + 4] + 2 ) >> 2 );
+		}
+	}
+
+	return result;
+}
+
+/**
+	@return	The image reduced to the given size. The image is repeatedly
+			halved with a box filter, which is fast and does not alias, and
+			the remainder is covered with a single smooth scale.
+**/
+QImage downscaleImage( const QImage &image, const QSize &size )
+{
+	QImage result = image;
+	if ( result.format() != QImage::Format_RGB32
+		&& result.format() != QImage::Format_ARGB32_Premultiplied )
+	{
+		result = result.convertToFormat( QImage::Format_ARGB32_Premultiplied );
+	}
+
+	while ( result.width() / 2 >= size.width()
+		&& result.height() / 2 >= size.height() )
+	{
+		result = halveImage( result );
+	}
+
+	if ( result.size() != size )
+	{
+		result = result.scaled( size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+	}
+
+	return result;
+}
+
+/**
+	Limits the number of proxies that are decoded at the same time, regardless
+	of the size of the thread pool. A decode that holds the full size image
+	takes every slot, so that only one such image is in memory at a time.
+**/
+const int c_proxyDecodeSlots = 2;
+QSemaphore s_proxyDecodeSlots( c_proxyDecodeSlots );
+
+const qint64 c_textureProxiesMaxSize = Q_INT64_C( 2 ) << 30; // bytes
+
+/**
+	Bounds the total size of the proxy folder by removing the least recently
+	used proxies first, by the later of their last read and last modified
+	times. A scene saved with a proxy that has since been removed loses that
+	map in the viewport; it can be restored from the original path recorded
+	on the material.
+
+	@sa DzFbxImporter::recordTextureProxyOriginals()
+**/
+void pruneTextureProxies( const QString &proxyFolderPath )
+{
+	// sorted from the least recently used
+	QMultiMap<QDateTime, QFileInfo> proxies;
+	qint64 totalSize = 0;
+
+	const QFileInfoList fileInfos = QDir( proxyFolderPath ).entryInfoList( QStringList( "*.png" ), QDir::Files );
+	for ( int i = 0; i < fileInfos.count(); i++ )
+	{
+		const QFileInfo &fileInfo = fileInfos[i];
+		proxies.insert( qMax( fileInfo.lastRead(), fileInfo.lastModified() ), fileInfo );
+		totalSize += fileInfo.size();
+	}
+
+	QMultiMap<QDateTime, QFileInfo>::const_iterator proxyIt = proxies.constBegin();
+	for ( ; proxyIt != proxies.constEnd() && totalSize > c_textureProxiesMaxSize; ++proxyIt )
+	{
+		if ( QFile::remove( proxyIt.value().absoluteFilePath() ) )
+		{
+			totalSize -= proxyIt.value().size();
+		}
+	}
+}
+
+/**
+	Generates a downscaled copy of an image file if it is larger than the
+	maximum size, or finds one generated by a previous import. Formats that
+	support it are decoded straight to the proxy size; others are decoded at
+	full size and reduced with downscaleImage().
+
+	@return	The path of the proxy, or an empty string if the image does not
+			need one or cannot be read.
+**/
+QString generateTextureProxy( const QString &filePath, int maxSize, const QString &proxyFolderPath )
+{
+	QImageReader reader( filePath );
+	const QSize size = reader.size();
+	if ( !size.isValid()
+		|| ( size.width() <= maxSize && size.height() <= maxSize ) )
+	{
+		return QString();
+	}
+
+	// proxies are keyed by the source and its modification time so that
+	// they are regenerated when the source changes
+	const QFileInfo fileInfo( filePath );
+	const QString key = QString( "%1|%2|%3" )
+		.arg( fileInfo.absoluteFilePath() )
+		.arg( fileInfo.lastModified().toTime_t() )
+		.arg( maxSize );
+	const QByteArray keyHash = QCryptographicHash::hash( key.toUtf8(), QCryptographicHash::Sha1 ).toHex();
+	const QString proxyPath = QDir( proxyFolderPath ).filePath( QString::fromLatin1( keyHash ) + ".png" );
+	if ( QFileInfo( proxyPath ).isFile() )
+	{
+		return proxyPath;
+	}
+
+	QSize proxySize = size;
+	proxySize.scale( maxSize, maxSize, Qt::KeepAspectRatio );
+	proxySize = proxySize.expandedTo( QSize( 1, 1 ) );
+
+	QImage image;
+	bool isRead = false;
+	if ( reader.supportsOption( QImageIOHandler::ScaledSize ) )
+	{
+		reader.setScaledSize( proxySize );
+
+		s_proxyDecodeSlots.acquire();
+		isRead = reader.read( &image );
+		s_proxyDecodeSlots.release();
+	}
+	else
+	{
+		s_proxyDecodeSlots.acquire( c_proxyDecodeSlots );
+		isRead = reader.read( &image );
+		if ( isRead )
+		{
+			image = downscaleImage( image, proxySize );
+		}
+		s_proxyDecodeSlots.release( c_proxyDecodeSlots );
+	}
+
+	if ( !isRead )
+	{
+		return QString();
+	}
+
+	// write to a temporary file first, so that an interrupted or concurrent
+	// write never leaves a partial proxy behind
+	QTemporaryFile tmpFile( proxyPath + ".XXXXXX" );
+	if ( !tmpFile.open()
+		|| !image.save( &tmpFile, "PNG" ) )
+	{
+		return QString();
+	}
+
+	// the file would otherwise be removed, under its new name, when the
+	// temporary is destroyed
+	tmpFile.setAutoRemove( false );
+	tmpFile.close();
+	if ( !tmpFile.rename( proxyPath ) )
+	{
+		// another import may have written the same proxy first
+		QFile::remove( tmpFile.fileName() );
+		if ( !QFileInfo( proxyPath ).isFile() )
+		{
+			return QString();
+		}
+	}
+
+	return proxyPath;
+}
+
+/**
+	Resolves a texture file name to an existing file and reads the file ahead,
+	once, so that the image decode on the main thread does not wait on disk or
+	network I/O. The image itself is not decoded here, since the image manager
+	only loads images from files. The file index is consulted first; the name
+	is only probed as-is, then relative to the folder of the FBX file, if the
+	index has no match or more than one equally good match.
+	If a maximum proxy size is set, images larger than it are replaced by a
+	downscaled proxy instead of being read through.
+
+	Results are pairs of the resolved path and the proxy path, either of
+	which may be empty. Instances are invoked concurrently, so only value
+	copies are shared.
+**/
+class TextureReadAhead {
+public:
+	typedef QPair<QString, QString> result_type;
+
+	TextureReadAhead( const QString &folderPath, const QMultiHash<QString, QString> &fileIndex,
+		int proxyMaxSize, const QString &proxyFolderPath ) :
+		m_folderPath( folderPath ), m_fileIndex( fileIndex ),
+		m_proxyMaxSize( proxyMaxSize ), m_proxyFolderPath( proxyFolderPath )
+	{}
+
+	result_type operator()( const QString &fileName ) const
+	{
+		// the disk is only probed if the index has no single best match
+		bool isAmbiguous = false;
+		QString filePath = findIndexedTextureFile( m_fileIndex, fileName, isAmbiguous );
+		if ( filePath.isEmpty()
+			|| isAmbiguous )
+		{
+			const QString relFilePath = QDir( m_folderPath ).filePath( fileName );
+			if ( QFileInfo( fileName ).isFile() )
+			{
+				filePath = fileName;
+			}
+			else if ( QFileInfo( relFilePath ).isFile() )
+			{
+				filePath = relFilePath;
+			}
+		}
+
+		if ( filePath.isEmpty() )
+		{
+			return result_type();
+		}
+
+		if ( m_proxyMaxSize > 0 )
+		{
+			const QString proxyPath = generateTextureProxy( filePath, m_proxyMaxSize, m_proxyFolderPath );
+			if ( !proxyPath.isEmpty() )
+			{
+				return result_type( filePath, proxyPath );
+			}
+		}
+
+		QFile file( filePath );
+		if ( file.open( QIODevice::ReadOnly ) )
+		{
+			const qint64 chunkSize = 1 << 20;
+			QByteArray chunk;
+			do
+			{
+				chunk = file.read( chunkSize );
+			}
+			while ( !chunk.isEmpty() );
+		}
+
+		return result_type( filePath, QString() );
+	}
+
+private:
+	QString							m_folderPath;
+	QMultiHash<QString, QString>	m_fileIndex;
+	int								m_proxyMaxSize;
+	QString							m_proxyFolderPath;
+};
+
+} //namespace
+
+/**
+	Builds an index of the texture files that can be found in the folder of the
+	FBX file, the folder that embedded media is extracted to, and the texture
+	search paths, by lower case file name. Texture references are resolved
+	against the index, instead of probing each candidate path on disk, which
+	is slow on network shares. The reference is only probed as stored, then
+	relative to the FBX file, if the index has no match, or more than one
+	equally good match.
+
+	The folder of the FBX file is not searched recursively. If the same file
+	name is found more than once, the file with the longest path suffix in
+	common with the reference is used, then the first in the order above.
+
+	@sa fbxReadAheadTextures()
+**/
+void DzFbxImporter::fbxIndexTextureFolders()
+{
+	m_textureFileIndex.clear();
+
+	indexTextureFolder( m_folder.absolutePath(), false, m_textureFileIndex );
+	indexTextureFolder( m_embeddedMediaPath, true, m_textureFileIndex );
+
+	const QStringList searchPaths = m_textureSearchPaths.split( ';', QString::SkipEmptyParts );
+	for ( int i = 0; i < searchPaths.count(); i++ )
+	{
+		indexTextureFolder( searchPaths[i].trimmed(), true, m_textureFileIndex );
+	}
+}
+
+/**
+	Starts a read-ahead of every file texture in the scene on the global
+	thread pool, so that texture I/O overlaps with the conversion of the
+	graph and the meshes. This only resolves the files and warms the file
+	system cache; the images are still decoded on the main thread, by the
+	image manager, when toTexture() picks up the results. Proxies for
+	oversized textures are generated on the pool too, if enabled, after the
+	proxy folder is pruned.
+
+	Nothing is started if the file could not be read.
+
+	@sa fbxIndexTextureFolders()
+	@sa toTexture()
+**/
+void DzFbxImporter::fbxReadAheadTextures()
+{
+	m_textureReadAheadMap.clear();
+
+	QStringList fileNames;
+	for ( int i = 0, n = m_fbxScene->GetSrcObjectCount<FbxFileTexture>(); i < n; i++ )
+	{
+		const FbxFileTexture* fbxFileTexture = m_fbxScene->GetSrcObject<FbxFileTexture>( i );
+		const QString fileName( fbxFileTexture->GetFileName() );
+		if ( fileName.isEmpty()
+			|| m_textureReadAheadMap.contains( fileName ) )
+		{
+			continue;
+		}
+
+		m_textureReadAheadMap.insert( fileName, fileNames.count() );
+		fileNames.append( fileName );
+	}
+
+	if ( fileNames.isEmpty() )
+	{
+		return;
+	}
+
+	fbxIndexTextureFolders();
+
+	int proxyMaxSize = m_textureProxyMaxSize;
+	const QString proxyFolderPath = QDir( dzApp->getAppDataPath() ).filePath( "FBX Importer/Texture Proxies" );
+	if ( proxyMaxSize > 0 )
+	{
+		if ( QDir().mkpath( proxyFolderPath ) )
+		{
+			pruneTextureProxies( proxyFolderPath );
+		}
+		else
+		{
+			proxyMaxSize = 0;
+		}
+	}
+
+	m_textureReadAhead = QtConcurrent::mapped( fileNames,
+		TextureReadAhead( m_folder.absolutePath(), m_textureFileIndex, proxyMaxSize, proxyFolderPath ) );
+}
+
+/**
+**/
+DzTexture* DzFbxImporter::toTexture( FbxProperty fbxProperty )
+{
+	for ( int i = 0; i < fbxProperty.GetSrcObjectCount<FbxFileTexture>(); ++i )
+	{
+		const FbxFileTexture* fbxFileTexture = fbxProperty.GetSrcObject<FbxFileTexture>( i );
+		const QString fileName( fbxFileTexture->GetFileName() );
+
+		// the same files are commonly referenced by many materials, so each
+		// path is only resolved once per import; misses are cached too
+		QHash<QString, DzTexturePtr>::const_iterator cacheIt = m_textureCache.constFind( fileName );
+		if ( cacheIt != m_textureCache.constEnd() )
+		{
+			return cacheIt.value();
+		}
+
+		const DzImageMgr* imgMgr = dzApp->getImageMgr();
+
+		// use the path resolved by the read-ahead; this blocks until the
+		// read-ahead of the file is done
+		const int readAheadIdx = m_textureReadAheadMap.value( fileName, -1 );
+		if ( readAheadIdx >= 0 )
+		{
+			const QPair<QString, QString> readAhead = m_textureReadAhead.resultAt( readAheadIdx );
+			if ( !readAhead.second.isEmpty() )
+			{
+				DzTexturePtr dsTexture = imgMgr->getImage( readAhead.second );
+				if ( dsTexture )
+				{
+					m_textureCache.insert( fileName, dsTexture );
+					m_textureProxyOriginals.insert( dsTexture, readAhead.first );
+
+					return dsTexture;
+				}
+			}
+
+			if ( !readAhead.first.isEmpty() )
+			{
+				DzTexturePtr dsTexture = imgMgr->getImage( readAhead.first );
+				m_textureCache.insert( fileName, dsTexture );
+
+				return dsTexture;
+			}
+		}
+
+		DzTexturePtr dsTexture = imgMgr->getImage( fileName );
+		if ( !dsTexture )
+		{
+			const QString filePath = m_folder.filePath( fileName );
+			cacheIt = m_textureCache.constFind( filePath );
+			if ( cacheIt != m_textureCache.constEnd() )
+			{
+				dsTexture = cacheIt.value();
+			}
+			else
+			{
+				dsTexture = imgMgr->getImage( filePath );
+				m_textureCache.insert( filePath, dsTexture );
+			}
+		}
+
+		m_textureCache.insert( fileName, dsTexture );
+
+		return dsTexture;
+	}
+
+	return 0;
+}
+
+namespace
+{
+
+struct WeldCell
+{
+	WeldCell( qint64 x, qint64 y, qint64 z ) :
+		x( x ), y( y ), z( z )
+	{}
+
+	bool operator==( const WeldCell &other ) const
+	{
+		return x == other.x && y == other.y && z == other.z;
+	}
+
+	qint64	x;
+	qint64	y;
+	qint64	z;
+};
+
+uint qHash( const WeldCell &cell )
+{
+	return ::qHash( ( cell.x * 73856093 ) ^ ( cell.y * 19349663 ) ^ ( cell.z * 83492791 ) );
+}
+
+} //namespace
+
+/**
+	Builds a map that collapses control points lying within the weld tolerance
+	of each other into a single vertex. Exporters commonly split control points
+	along UV seams and hard edges; welding them lets the mesh, skinning and
+	morph stages operate on the reduced vertex set.
+
+	Control points are bucketed in a spatial hash whose cell size equals the
+	tolerance, so each control point is only compared against the vertices
+	in its own and the adjacent cells.
+
+	@param fbxMesh	The mesh whose control points are to be welded.
+	@param weld		Receives the control point to vertex mapping. If welding
+					is disabled, or nothing was welded, the mapping is left
+					empty (identity).
+
+	@sa fbxImportMesh()
+**/
+void DzFbxImporter::fbxWeldVertices( FbxMesh* fbxMesh, VertexWeld &weld )
+{
+	const int numControlPoints = fbxMesh->GetControlPointsCount();
+
+	weld.numControlPoints = numControlPoints;
+	weld.numVertices = numControlPoints;
+	weld.map.clear();
+	weld.sources.clear();
+
+	if ( !m_weldVertices
+		|| m_weldTolerance <= 0.0
+		|| numControlPoints < 2 )
+	{
+		return;
+	}
+
+	const FbxVector4* fbxVertices = fbxMesh->GetControlPoints();
+	const double invCellSize = 1.0 / m_weldTolerance;
+	const double toleranceSq = m_weldTolerance * m_weldTolerance;
+
+	// head of the chain of vertices in each cell, and the next vertex in
+	// the same cell for each vertex
+	QHash<WeldCell, int> cellHeads;
+	cellHeads.reserve( numControlPoints );
+	QVector<int> cellNext;
+	cellNext.reserve( numControlPoints );
+
+	weld.map.resize( numControlPoints );
+	weld.sources.reserve( numControlPoints );
+
+	for ( int cpIdx = 0; cpIdx < numControlPoints; cpIdx++ )
+	{
+		const FbxVector4 &fbxPos = fbxVertices[cpIdx];
+		const qint64 cellX = static_cast<qint64>( floor( fbxPos[0] * invCellSize ) );
+		const qint64 cellY = static_cast<qint64>( floor( fbxPos[1] * invCellSize ) );
+		const qint64 cellZ = static_cast<qint64>( floor( fbxPos[2] * invCellSize ) );
+
+		int vertIdx = -1;
+		for ( int dx = -1; dx <= 1 && vertIdx < 0; dx++ )
+		{
+			for ( int dy = -1; dy <= 1 && vertIdx < 0; dy++ )
+			{
+				for ( int dz = -1; dz <= 1 && vertIdx < 0; dz++ )
+				{
+					const QHash<WeldCell, int>::const_iterator cellIt =
+						cellHeads.constFind( WeldCell( cellX + dx, cellY + dy, cellZ + dz ) );
+					if ( cellIt == cellHeads.constEnd() )
+					{
+						continue;
+					}
+
+					for ( int candIdx = cellIt.value(); candIdx >= 0; candIdx = cellNext[candIdx] )
+					{
+						const FbxVector4 &fbxCandPos = fbxVertices[weld.sources[candIdx]];
+						const double distX = fbxPos[0] - fbxCandPos[0];
+						const double distY = fbxPos[1] - fbxCandPos[1];
+						const double distZ = fbxPos[2] - fbxCandPos[2];
+						if ( distX * distX + distY * distY + distZ * distZ <= toleranceSq )
+						{
+							vertIdx = candIdx;
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		if ( vertIdx < 0 )
+		{
+			vertIdx = weld.sources.count();
+			weld.sources.append( cpIdx );
+
+			const WeldCell cell( cellX, cellY, cellZ );
+			cellNext.append( cellHeads.value( cell, -1 ) );
+			cellHeads.insert( cell, vertIdx );
+		}
+
+		weld.map[cpIdx] = vertIdx;
+	}
+
+	if ( weld.sources.count() == numControlPoints )
+	{
+		weld.map.clear();
+		weld.sources.clear();
+		return;
+	}
+
+	weld.numVertices = weld.sources.count();
+}
+
+/**
+	Only the skin weights, morph deltas and vertex creases of the first control
+	point of each welded vertex are imported. Reports, in the error list, each
+	kind of data that differs between a control point that was merged and the
+	control point it was merged into, since that data is lost.
+
+	@param fbxMesh	The mesh whose control points were welded.
+	@param weld		The control point to vertex mapping.
+
+	@sa fbxWeldVertices()
+**/
+void DzFbxImporter::fbxCheckWeldedData( FbxMesh* fbxMesh, const VertexWeld &weld )
+{
+	if ( weld.map.isEmpty() )
+	{
+		return;
+	}
+
+	// the control points that were merged into another, and those that
+	// take part in a merge on either side
+	const int numControlPoints = weld.numControlPoints;
+	QVector<int> merged;
+	QVector<bool> involved( numControlPoints, false );
+	for ( int cpIdx = 0; cpIdx < numControlPoints; cpIdx++ )
+	{
+		if ( !weld.isSource( cpIdx ) )
+		{
+			merged.append( cpIdx );
+			involved[cpIdx] = true;
+			involved[weld.source( weld.vertex( cpIdx ) )] = true;
+		}
+	}
+
+	const double tolerance = 1e-4;
+	const QString meshName( fbxMesh->GetNode() ? fbxMesh->GetNode()->GetName() : fbxMesh->GetName() );
+
+	// skin weights
+	bool differs = false;
+	for ( int i = 0, n = fbxMesh->GetDeformerCount( FbxDeformer::eSkin ); i < n && !differs; i++ )
+	{
+		FbxSkin* fbxSkin = FbxCast<FbxSkin>( fbxMesh->GetDeformer( i, FbxDeformer::eSkin ) );
+		for ( int j = 0, m = fbxSkin->GetClusterCount(); j < m && !differs; j++ )
+		{
+			FbxCluster* fbxCluster = fbxSkin->GetCluster( j );
+			const int* fbxIndices = fbxCluster->GetControlPointIndices();
+			const double* fbxWeights = fbxCluster->GetControlPointWeights();
+
+			QHash<int, double> weights;
+			for ( int k = 0, p = fbxCluster->GetControlPointIndicesCount(); k < p; k++ )
+			{
+				const int cpIdx = fbxIndices[k];
+				if ( weld.contains( cpIdx )
+					&& involved[cpIdx] )
+				{
+					weights.insert( cpIdx, fbxWeights[k] );
+				}
+			}
+
+			for ( int k = 0; k < merged.count() && !weights.isEmpty(); k++ )
+			{
+				const int cpIdx = merged[k];
+				const int srcIdx = weld.source( weld.vertex( cpIdx ) );
+				if ( qAbs( weights.value( cpIdx ) - weights.value( srcIdx ) ) > tolerance )
+				{
+					differs = true;
+					break;
+				}
+			}
+		}
+	}
+
+	if ( differs )
+	{
+		m_errorList << "Welding: Merged control points have different skin weights: " % meshName;
+	}
+
+	// morph deltas
+	const FbxVector4* fbxVertices = fbxMesh->GetControlPoints();
+	differs = false;
+	for ( int i = 0, n = fbxMesh->GetDeformerCount( FbxDeformer::eBlendShape ); i < n && !differs; i++ )
+	{
+		FbxBlendShape* fbxBlendShape = FbxCast<FbxBlendShape>( fbxMesh->GetDeformer( i, FbxDeformer::eBlendShape ) );
+		for ( int j = 0, m = fbxBlendShape->GetBlendShapeChannelCount(); j < m && !differs; j++ )
+		{
+			FbxBlendShapeChannel* fbxBlendChannel = fbxBlendShape->GetBlendShapeChannel( j );
+			for ( int k = 0, p = fbxBlendChannel->GetTargetShapeCount(); k < p && !differs; k++ )
 			{
-				roughness = 1.0 - ((log( fbxPhong->Shininess.Get() ) / log( 2.0 )) - 2) / 10;
+				FbxShape* fbxTargetShape = fbxBlendChannel->GetTargetShape( k );
+				const FbxVector4* fbxTargetVerts = fbxTargetShape->GetControlPoints();
+				const int* fbxTargetIndices = fbxTargetShape->GetControlPointIndices();
+				const int numTargetVerts = fbxTargetIndices ?
+					fbxTargetShape->GetControlPointIndicesCount() :
+					qMin( fbxTargetShape->GetControlPointsCount(), numControlPoints );
+
+				QHash<int, FbxVector4> deltas;
+				for ( int q = 0; q < numTargetVerts; q++ )
+				{
+					const int cpIdx = fbxTargetIndices ? fbxTargetIndices[q] : q;
+					if ( weld.contains( cpIdx )
+						&& involved[cpIdx] )
+					{
+						deltas.insert( cpIdx, fbxTargetVerts[cpIdx] - fbxVertices[cpIdx] );
+					}
+				}
+
+				for ( int q = 0; q < merged.count() && !deltas.isEmpty(); q++ )
+				{
+					const int cpIdx = merged[q];
+					const int srcIdx = weld.source( weld.vertex( cpIdx ) );
+					const FbxVector4 delta = deltas.value( cpIdx, FbxVector4( 0, 0, 0, 0 ) );
+					const FbxVector4 srcDelta = deltas.value( srcIdx, FbxVector4( 0, 0, 0, 0 ) );
+					if ( qAbs( delta[0] - srcDelta[0] ) > tolerance
+						|| qAbs( delta[1] - srcDelta[1] ) > tolerance
+						|| qAbs( delta[2] - srcDelta[2] ) > tolerance )
+					{
+						differs = true;
+						break;
+					}
+				}
+			}
+		}
+	}
 
-				FbxDouble3 spec = fbxPhong->Specular.Get();
-				float innerDistance = qAbs( spec[1] - spec[0] ) + qAbs( spec[2] - spec[0] ) + qAbs( spec[2] - spec[1] );
-				metallicity = qMin( 1.0f, innerDistance );
+	if ( differs )
+	{
+		m_errorList << "Welding: Merged control points have different morph deltas: " % meshName;
+	}
+
+	// vertex creases
+	differs = false;
+	for ( int i = 0, n = fbxMesh->GetElementVertexCreaseCount(); i < n && !differs; i++ )
+	{
+		const FbxGeometryElementCrease* fbxSubdVertexCrease = fbxMesh->GetElementVertexCrease( i );
+		const int numCreases = fbxSubdVertexCrease->GetDirectArray().GetCount();
+		for ( int j = 0; j < merged.count(); j++ )
+		{
+			const int cpIdx = merged[j];
+			const int srcIdx = weld.source( weld.vertex( cpIdx ) );
+			const double weight = cpIdx < numCreases ? fbxSubdVertexCrease->GetDirectArray().GetAt( cpIdx ) : 0.0;
+			const double srcWeight = srcIdx < numCreases ? fbxSubdVertexCrease->GetDirectArray().GetAt( srcIdx ) : 0.0;
+			if ( qAbs( weight - srcWeight ) > tolerance )
+			{
+				differs = true;
+				break;
 			}
 		}
-		else if ( FbxSurfaceLambert* fbxLambert = FbxCast<FbxSurfaceLambert>( fbxMaterial ) )
+	}
+
+	if ( differs )
+	{
+		m_errorList << "Welding: Merged control points have different crease weights: " % meshName;
+	}
+}
+
+/**
+**/
+void DzFbxImporter::fbxImportVertices( const VertexWeld &weld, FbxVector4* fbxVertices, DzFacetMesh* dsMesh, DzVec3 offset )
+{
+	DzPnt3* dsVertices = dsMesh->setVertexArray( weld.numVertices );
+	for ( int i = 0; i < weld.numVertices; i++ )
+	{
+		const FbxVector4 &fbxVertex = fbxVertices[weld.source( i )];
+		dsVertices[i][0] = fbxVertex[0] + offset[0];
+		dsVertices[i][1] = fbxVertex[1] + offset[1];
+		dsVertices[i][2] = fbxVertex[2] + offset[2];
+	}
+}
+
+/**
+**/
+void DzFbxImporter::fbxImportUVs( FbxMesh* fbxMesh, DzFacetMesh* dsMesh )
+{
+	for ( int i = 0, n = fbxMesh->GetElementUVCount(); i < n; i++ )
+	{
+		const FbxGeometryElementUV* fbxGeomUv = fbxMesh->GetElementUV( i );
+		const int numUvs = fbxGeomUv->GetDirectArray().GetCount();
+
+		DzMap* dsUvMap = dsMesh->getUVs();
+		dsUvMap->setNumValues( numUvs );
+		DzPnt2* dsUVs = dsUvMap->getPnt2ArrayPtr();
+
+		for ( int j = 0; j < numUvs; j++ )
 		{
-			diffuseColor = toQColor( fbxLambert->Diffuse );
-			diffuseMap = toTexture( fbxLambert->Diffuse );
+			const FbxVector2 fbxUv = fbxGeomUv->GetDirectArray().GetAt( j );
+			dsUVs[j][0] = fbxUv[0];
+			dsUVs[j][1] = fbxUv[1];
+		}
+
+		// only do the first
+		break;
+	}
+}
 
-			// Maya and Max want transparency in the color
-			opacityBase = 1 - (fbxLambert->TransparentColor.Get()[0] + fbxLambert->TransparentColor.Get()[1] + fbxLambert->TransparentColor.Get()[2]) / 3;
-			opacityMap = toTexture( fbxLambert->TransparentColor );
+/**
+**/
+void DzFbxImporter::fbxImportSubdVertexWeights( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, const VertexWeld &weld, bool &enableSubd )
+{
+	for ( int i = 0, n = fbxMesh->GetElementVertexCreaseCount(); i < n; i++ )
+	{
+		const FbxGeometryElementCrease* fbxSubdVertexCrease = fbxMesh->GetElementVertexCrease( i );
+		for ( int j = 0, m = fbxSubdVertexCrease->GetDirectArray().GetCount(); j < m; j++ )
+		{
+			if ( !weld.contains( j )
+				|| !weld.isSource( j ) )
+			{
+				continue;
+			}
 
-			if ( dsDefMaterial )
+			const double weight = fbxSubdVertexCrease->GetDirectArray().GetAt( j );
+			if ( weight > 0 )
 			{
-				ambientColor = toQColor( fbxLambert->Ambient );
-				ambientMap = toTexture( fbxLambert->Ambient );
+				enableSubd = true;
+
+				const int vertIdx = weld.vertex( j );
+#if DZ_SDK_4_12_OR_GREATER
+				dsMesh->setVertexWeight( vertIdx, weight );
+#else
+				// DzFacetMesh::setVertexWeight() is not in the 4.5 SDK, so we
+				// attempt to use the meta-object to call the method.
 
-				ambientFactor = fbxLambert->AmbientFactor.Get();
+				bool im = QMetaObject::invokeMethod( dsMesh, "setVertexWeight",
+					Q_ARG( int, vertIdx ), Q_ARG( int, weight ) );
+				assert( im );
+#endif
 			}
 		}
 
-		dsMaterial->setName( fbxMaterial->GetName() );
+		// only do the first
+		break;
+	}
+}
+
+/**
+	Translates an FBX surface material into the values used to set up a
+	Daz Studio material, including the Phong/Lambert to PBR conversion and
+	the texture lookups.
+
+	@param fbxMaterial			The material to translate.
+	@param forDefaultMaterial	If true, the values are for a DzDefaultMaterial,
+								otherwise they are for a PBR material.
+	@param matData				Receives the translated values.
+
+	@sa fbxImportMaterials()
+**/
+void DzFbxImporter::fbxTranslateMaterial( FbxSurfaceMaterial* fbxMaterial, bool forDefaultMaterial, MaterialData &matData )
+{
+	matData.forDefaultMaterial = forDefaultMaterial;
+	matData.isPhong = false;
+	matData.name = fbxMaterial->GetName();
+
+	matData.diffuseColor = Qt::white;
+	matData.diffuseMap = NULL;
+
+	matData.diffuseFactor = 1.0f;
+
+	matData.opacityBase = 1.0f;
+	matData.opacityMap = NULL;
+
+	matData.ambientColor = Qt::black;
+	matData.ambientMap = NULL;
+
+	matData.ambientFactor = 1.0f;
+
+	matData.specularColor = Qt::white;
+	matData.specularMap = NULL;
+
+	matData.specularFactor = 1.0f;
+
+	matData.shininess = 1.0f;
+	matData.shininessMap = NULL;
+
+	matData.reflectionFactor = 1.0f;
+	matData.reflectionMap = NULL;
+
+	matData.roughness = 0.1f;
+	matData.metallicity = 1.0f;
+
+	FbxSurfacePhong* fbxPhong = FbxCast<FbxSurfacePhong>( fbxMaterial );
+	if ( fbxPhong )
+	{
+		matData.isPhong = true;
+
+		matData.diffuseColor = toQColor( fbxPhong->Diffuse );
+		matData.diffuseMap = toTexture( fbxPhong->Diffuse );
+
+		// Maya and Max want transparency in the color
+		matData.opacityBase = 1 - (fbxPhong->TransparentColor.Get()[0] + fbxPhong->TransparentColor.Get()[1] + fbxPhong->TransparentColor.Get()[2]) / 3;
+		matData.opacityMap = toTexture( fbxPhong->TransparentColor );
+
+		if ( forDefaultMaterial )
+		{
+			matData.diffuseFactor = fbxPhong->DiffuseFactor.Get();
+
+			matData.ambientColor = toQColor( fbxPhong->Ambient );
+			matData.ambientMap = toTexture( fbxPhong->Ambient );
+
+			matData.ambientFactor = fbxPhong->AmbientFactor.Get();
+
+			matData.specularColor = toQColor( fbxPhong->Specular );
+			matData.specularMap = toTexture( fbxPhong->Specular );
+
+			matData.specularFactor = fbxPhong->SpecularFactor.Get();
+
+			matData.shininess = fbxPhong->Shininess.Get();
+			matData.shininessMap = toTexture( fbxPhong->Shininess );
+
+			matData.reflectionFactor = fbxPhong->ReflectionFactor.Get();
+			matData.reflectionMap = toTexture( fbxPhong->ReflectionFactor );
+		}
+		else //DzPbrMaterial or DzUberIrayMaterial
+		{
+			matData.roughness = 1.0 - ((log( fbxPhong->Shininess.Get() ) / log( 2.0 )) - 2) / 10;
+
+			FbxDouble3 spec = fbxPhong->Specular.Get();
+			float innerDistance = qAbs( spec[1] - spec[0] ) + qAbs( spec[2] - spec[0] ) + qAbs( spec[2] - spec[1] );
+			matData.metallicity = qMin( 1.0f, innerDistance );
+		}
+	}
+	else if ( FbxSurfaceLambert* fbxLambert = FbxCast<FbxSurfaceLambert>( fbxMaterial ) )
+	{
+		matData.diffuseColor = toQColor( fbxLambert->Diffuse );
+		matData.diffuseMap = toTexture( fbxLambert->Diffuse );
+
+		// Maya and Max want transparency in the color
+		matData.opacityBase = 1 - (fbxLambert->TransparentColor.Get()[0] + fbxLambert->TransparentColor.Get()[1] + fbxLambert->TransparentColor.Get()[2]) / 3;
+		matData.opacityMap = toTexture( fbxLambert->TransparentColor );
+
+		if ( forDefaultMaterial )
+		{
+			matData.ambientColor = toQColor( fbxLambert->Ambient );
+			matData.ambientMap = toTexture( fbxLambert->Ambient );
+
+			matData.ambientFactor = fbxLambert->AmbientFactor.Get();
+		}
+	}
+}
+
+/**
+	Proxies only stand in for the original textures while working in the
+	viewport. For each map of the material that is a proxy, the path of the
+	original is recorded in a string property next to the map, which is saved
+	with the scene, so that the original can be restored for final renders.
+
+	@param dsMaterial	The material whose maps have been set.
+
+	@sa toTexture()
+**/
+void DzFbxImporter::recordTextureProxyOriginals( DzMaterial* dsMaterial )
+{
+	QList<DzNumericProperty*> mapProps;
+	for ( int i = 0, n = dsMaterial->getNumProperties(); i < n; i++ )
+	{
+		DzNumericProperty* numProp = qobject_cast<DzNumericProperty*>( dsMaterial->getProperty( i ) );
+		if ( numProp
+			&& m_textureProxyOriginals.contains( numProp->getMapValue() ) )
+		{
+			mapProps.append( numProp );
+		}
+	}
+
+	for ( int i = 0; i < mapProps.count(); i++ )
+	{
+		const DzNumericProperty* mapProp = mapProps[i];
+
+		DzStringProperty* originalProp = new DzStringProperty( mapProp->getName() % " Original", false, true );
+		originalProp->setLabel( mapProp->getLabel() % " Original" );
+		originalProp->setPath( mapProp->getPath() );
+		originalProp->setValue( m_textureProxyOriginals.value( mapProp->getMapValue() ) );
+		dsMaterial->addProperty( originalProp );
+	}
+}
+
+/**
+**/
+void DzFbxImporter::fbxImportMaterials( FbxNode* fbxNode, FbxMesh* fbxMesh, DzFacetMesh* dsMesh, DzFacetShape* dsShape, bool &matsAllSame )
+{
+	for ( int i = 0, n = fbxNode->GetMaterialCount(); i < n; i++ )
+	{
+		FbxSurfaceMaterial* fbxMaterial = fbxNode->GetMaterial( i );
+		DzMaterialPtr dsMaterial = NULL;
+
+		if ( QObject* pbrMatInstance = m_pbrMatFactory ? m_pbrMatFactory->createInstance() : NULL )
+		{
+			dsMaterial = qobject_cast<DzMaterial*>( pbrMatInstance );
+		}
+		else
+		{
+			dsMaterial = new DzDefaultMaterial();
+		}
+
+		DzDefaultMaterial* dsDefMaterial = qobject_cast<DzDefaultMaterial*>( dsMaterial );
+
+		// materials are commonly shared by many nodes, so each one is only
+		// translated once per import; every shape still gets its own instance
+		QHash<FbxSurfaceMaterial*, MaterialData>::iterator matDataIt = m_materialDataMap.find( fbxMaterial );
+		if ( matDataIt == m_materialDataMap.end()
+			|| matDataIt.value().forDefaultMaterial != ( dsDefMaterial != NULL ) )
+		{
+			MaterialData matData;
+			fbxTranslateMaterial( fbxMaterial, dsDefMaterial != NULL, matData );
+			matDataIt = m_materialDataMap.insert( fbxMaterial, matData );
+		}
+
+		const MaterialData &matData = matDataIt.value();
+
+		dsMaterial->setName( matData.name );
 
-		dsMaterial->setDiffuseColor( diffuseColor );
-		dsMaterial->setColorMap( diffuseMap );
+		dsMaterial->setDiffuseColor( matData.diffuseColor );
+		dsMaterial->setColorMap( matData.diffuseMap );
 
-		dsMaterial->setBaseOpacity( opacityBase );
-		dsMaterial->setOpacityMap( opacityMap );
+		dsMaterial->setBaseOpacity( matData.opacityBase );
+		dsMaterial->setOpacityMap( matData.opacityMap );
 
 		if ( dsDefMaterial )
 		{
-			dsDefMaterial->setAmbientColor( ambientColor );
-			dsDefMaterial->setAmbientColorMap( ambientMap );
+			dsDefMaterial->setAmbientColor( matData.ambientColor );
+			dsDefMaterial->setAmbientColorMap( matData.ambientMap );
 
-			dsDefMaterial->setAmbientStrength( ambientFactor );
+			dsDefMaterial->setAmbientStrength( matData.ambientFactor );
 
-			if ( fbxPhong )
+			if ( matData.isPhong )
 			{
-				dsDefMaterial->setDiffuseStrength( diffuseFactor );
+				dsDefMaterial->setDiffuseStrength( matData.diffuseFactor );
 
-				dsDefMaterial->setSpecularColor( specularColor );
-				dsDefMaterial->setSpecularColorMap( specularMap );
+				dsDefMaterial->setSpecularColor( matData.specularColor );
+				dsDefMaterial->setSpecularColorMap( matData.specularMap );
 
-				dsDefMaterial->setSpecularStrength( specularFactor );
+				dsDefMaterial->setSpecularStrength( matData.specularFactor );
 
-				dsDefMaterial->setGlossinessStrength( shininess );
-				dsDefMaterial->setGlossinessValueMap( shininessMap );
+				dsDefMaterial->setGlossinessStrength( matData.shininess );
+				dsDefMaterial->setGlossinessValueMap( matData.shininessMap );
 
-				dsDefMaterial->setReflectionStrength( reflectionFactor );
-				dsDefMaterial->setReflectionMap( reflectionMap );
+				dsDefMaterial->setReflectionStrength( matData.reflectionFactor );
+				dsDefMaterial->setReflectionMap( matData.reflectionMap );
 			}
 		}
-		else if ( fbxPhong ) //DzPbrMaterial or DzUberIrayMaterial
+		else if ( matData.isPhong ) //DzPbrMaterial or DzUberIrayMaterial
 		{
 			// Because DzPbrMaterial is not in the public SDK, we attempt to use
 			// the meta-object to call the methods. If this fails, we attempt to
@@ -2142,25 +4090,30 @@ void DzFbxImporter::fbxImportMaterials( FbxNode* fbxNode, FbxMesh* fbxMesh, DzFa
 
 			// use "setGlossyRoughness" double if using DzUberIrayMaterial
 			if ( !QMetaObject::invokeMethod( dsMaterial,
-				"setRoughness", Q_ARG( float, roughness ) ) )
+				"setRoughness", Q_ARG( float, matData.roughness ) ) )
 			{
 				if ( DzFloatProperty* fProp = qobject_cast<DzFloatProperty*>( dsMaterial->findProperty( "Glossy Roughness" ) ) )
 				{
-					fProp->setValue( roughness );
+					fProp->setValue( matData.roughness );
 				}
 			}
 
 			//use "setMetallicity" double if using DzUberIrayMaterial
 			if ( !QMetaObject::invokeMethod( dsMaterial,
-				"setMetallicity", Q_ARG( float, metallicity ) ) )
+				"setMetallicity", Q_ARG( float, matData.metallicity ) ) )
 			{
 				if ( DzFloatProperty* fProp = qobject_cast<DzFloatProperty*>( dsMaterial->findProperty( "Metallic Weight" ) ) )
 				{
-					fProp->setValue( metallicity );
+					fProp->setValue( matData.metallicity );
 				}
 			}
 		}
 
+		if ( !m_textureProxyOriginals.isEmpty() )
+		{
+			recordTextureProxyOriginals( dsMaterial );
+		}
+
 		m_dsMaterials.push_back( dsMaterial );
 
 		dsShape->addMaterial( dsMaterial );
@@ -2196,52 +4149,50 @@ void DzFbxImporter::fbxImportMaterials( FbxNode* fbxNode, FbxMesh* fbxMesh, DzFa
 	}
 }
 
-#if !DZ_SDK_4_12_OR_GREATER
-static void selectFacetsByIndexList( DzFacetMesh* dsMesh, DzFaceGroup* dsFaceGroup )
+/**
+	Indexes the nodes in the bind poses of the scene, so that each node only
+	needs a single lookup. Every (pose, index) pair that references a node is
+	kept, since a node can be in more than one bind pose; the pair from the
+	last pose is found first.
+
+	@sa fbxImportGraph()
+	@sa fbxPreImportGraph()
+**/
+void DzFbxImporter::fbxPreImportBindPoses()
 {
-	const int nFacets = dsMesh->getNumFacets();
-	const int* faceGrpIndices = dsFaceGroup->getIndicesPtr();
-	unsigned char* facetFlags = dsMesh->getFacetFlagsPtr();
-	for ( int i = 0, n = dsFaceGroup->count(); i < n; ++i )
+	m_bindPoseMap.clear();
+
+	for ( int i = 0; i < m_fbxScene->GetPoseCount(); i++ )
 	{
-		const int faceGrpIdx = faceGrpIndices[i];
-		if ( faceGrpIdx >= nFacets )
+		FbxPose* pose = m_fbxScene->GetPose( i );
+		if ( !pose->IsBindPose() )
 		{
-			break;
+			continue;
 		}
 
-		if ( facetFlags[faceGrpIdx] & DZ_HIDDEN_FACE_BIT )
+		for ( int j = 0; j < pose->GetCount(); j++ )
 		{
-			continue;
+			m_bindPoseMap.insert( pose->GetNode( j ), qMakePair( pose, j ) );
 		}
-
-		facetFlags[faceGrpIdx] |= DZ_SELECTED_FACE_BIT;
 	}
 }
-#endif
 
 /**
-	Builds face groups, or polygon selection sets, from polygon selection set
-	data in the FBX.
-
-	@param dsMeshNode	The node that provides the mesh with the polygons we are
-						interested in. Used to validate that a given selection
-						set is intended for 'this' object.
-	@param dsMesh		The facet mesh that we will alter the face group(s) of.
-	@param dsShape		The shape to create a facet selection group on; depending
-						on the active options.
+	Indexes the polygon selection sets in the scene by the name of the mesh
+	node they are intended for, so that each mesh only needs a single lookup.
+	Selection set names take the form "<face group>__<mesh node>".
 
-	@sa fbxImportMesh()
+	@sa fbxImportPolygonSets()
 **/
-void DzFbxImporter::fbxImportPolygonSets( DzNode* dsMeshNode, DzFacetMesh* dsMesh, DzFacetShape* dsShape )
+void DzFbxImporter::fbxPreImportPolygonSets()
 {
+	m_polygonSetMap.clear();
+
 	if ( !m_includePolygonSets )
 	{
 		return;
 	}
 
-	const bool asFaceGroups = !m_includePolygonGroups;
-
 	for ( int i = 0, n = m_fbxScene->GetMemberCount<FbxSelectionSet>(); i < n; i++ )
 	{
 		FbxSelectionSet* fbxSelectionSet = m_fbxScene->GetMember<FbxSelectionSet>( i );
@@ -2254,8 +4205,7 @@ void DzFbxImporter::fbxImportPolygonSets( DzNode* dsMeshNode, DzFacetMesh* dsMes
 		QStringList fbxSelSetNameParts = fbxSelSetName.split( "__" );
 		const QString dsFaceGroupName( fbxSelSetNameParts.first() );
 		const QString dsMeshNodeName( fbxSelSetNameParts.last() );
-		if ( dsMeshNodeName == dsFaceGroupName
-			|| dsMeshNodeName != dsMeshNode->getName() )
+		if ( dsMeshNodeName == dsFaceGroupName )
 		{
 			continue;
 		}
@@ -2264,14 +4214,6 @@ void DzFbxImporter::fbxImportPolygonSets( DzNode* dsMeshNode, DzFacetMesh* dsMes
 		FbxArray<FbxObject*> fbxDirectObjectList;
 		fbxSelectionSet->GetSelectionNodesAndDirectObjects( fbxSelectionNodeList, fbxDirectObjectList );
 
-		// directly connected objects
-		for ( int j = 0, m = fbxDirectObjectList.GetCount(); j < m; j++ )
-		{
-			const FbxObject* fbxObject = fbxDirectObjectList[j];
-			const QString str( fbxObject->GetName() );
-			Q_UNUSED( str );
-		}
-
 		// selection nodes
 		for ( int j = 0, m = fbxSelectionNodeList.GetCount(); j < m; j++ )
 		{
@@ -2284,94 +4226,111 @@ void DzFbxImporter::fbxImportPolygonSets( DzNode* dsMeshNode, DzFacetMesh* dsMes
 			FbxArray<int> fbxFacetIndices;
 			fbxSelectionSet->GetFaceSelection( fbxSelectionNode, fbxFacetIndices );
 
-			if ( fbxFacetIndices.GetCount() < 1 )
+			const int numFacetIndices = fbxFacetIndices.GetCount();
+			if ( numFacetIndices < 1 )
 			{
 				continue;
 			}
 
-			if ( asFaceGroups )
+			PolygonSet polygonSet;
+			polygonSet.faceGroupName = dsFaceGroupName;
+			polygonSet.facetIndices.resize( numFacetIndices );
+			for ( int k = 0; k < numFacetIndices; k++ )
+			{
+				polygonSet.facetIndices[k] = fbxFacetIndices.GetAt( k );
+			}
+
+			m_polygonSetMap[dsMeshNodeName].append( polygonSet );
+		}
+	}
+}
+
+/**
+	Builds polygon selection sets from polygon selection set data in the FBX,
+	if they are not imported as face groups, and removes empty face groups.
+	Face groups are assigned while the facets are created.
+
+	@param dsMeshNode	The node that provides the mesh with the polygons we are
+						interested in. Used to validate that a given selection
+						set is intended for 'this' object.
+	@param dsMesh		The facet mesh that we will alter the face group(s) of.
+	@param dsShape		The shape to create a facet selection group on; depending
+						on the active options.
+	@param polygonFacets	The facets of polygon p are [polygonFacets[p],
+						polygonFacets[p + 1]); empty for a dropped polygon.
+
+	@sa fbxImportMesh()
+	@sa fbxImportFaces()
+	@sa fbxPreImportPolygonSets()
+**/
+void DzFbxImporter::fbxImportPolygonSets( DzNode* dsMeshNode, DzFacetMesh* dsMesh, DzFacetShape* dsShape, const QVector<int> &polygonFacets )
+{
+	if ( !m_includePolygonSets )
+	{
+		return;
+	}
+
+	const bool asFaceGroups = !m_includePolygonGroups;
+
+	// sets list polygons; an n-gon is split into several facets, and welding
+	// can drop polygons, so each polygon is expanded to its range of facets
+	QVector<PolygonSet> polygonSets = m_polygonSetMap.value( dsMeshNode->getName() );
+	if ( !asFaceGroups )
+	{
+		const int numPolygons = polygonFacets.count() - 1;
+		for ( int i = 0, n = polygonSets.count(); i < n; i++ )
+		{
+			QVector<int> &facetIndices = polygonSets[i].facetIndices;
+			QVector<int> remapped;
+			remapped.reserve( facetIndices.count() );
+			for ( int j = 0, m = facetIndices.count(); j < m; j++ )
 			{
-				const bool created = dsMesh->createFaceGroup( dsFaceGroupName );
-				Q_UNUSED( created )
-
-				const int numFacetIndices = fbxFacetIndices.GetCount();
-
-				// create a temporary list of facet indices to use for selection
-				DzTSharedPointer<DzFaceGroup> dsFaceGroup( new DzFaceGroup( dsFaceGroupName ) );
-				dsFaceGroup->preSizeArray( numFacetIndices );
-				for ( int k = 0; k < numFacetIndices; k++ )
+				const int polyIdx = facetIndices[j];
+				if ( polyIdx < 0 || polyIdx >= numPolygons )
 				{
-					dsFaceGroup->addIndex( fbxFacetIndices.GetAt( k ) );
+					continue;
 				}
 
-				// use facet selection state to create face groups;
-				// doing it this way more easily handles exclusivity
-#if DZ_SDK_4_12_OR_GREATER
-				dsMesh->beginFacetSelectionEdit();
-#else
-				// DzFacetMesh::beginFacetSelectionEdit() is not in the 4.5 SDK,
-				// so we attempt to use the meta-object to call the method - since 4.6.3.39
-
-				bool im = QMetaObject::invokeMethod( dsMesh, "beginFacetSelectionEdit" );
-				assert( im );
-#endif
-
-				dsMesh->deselectAllFacets();
-
-#if DZ_SDK_4_12_OR_GREATER
-				dsMesh->selectFacetsByIndexList( dsFaceGroup, true );
-#else
-				// DzFacetMesh::selectFacetsByIndexList() is not in the 4.5 SDK,
-				// so we attempt to use the meta-object to call the method - since 4.6.3.39.
-				// If that fails we fall back to doing it ourselves
-
-				if ( !QMetaObject::invokeMethod( dsMesh, "selectFacetsByIndexList",
-						Q_ARG( const DzIndexList*, dsFaceGroup ), Q_ARG( bool, true) ) )
+				for ( int facetIdx = polygonFacets[polyIdx]; facetIdx < polygonFacets[polyIdx + 1]; facetIdx++ )
 				{
-					selectFacetsByIndexList( dsMesh, dsFaceGroup );
+					remapped.append( facetIdx );
 				}
-#endif
-
-				dsMesh->addSelectedFacetsToGroup( dsFaceGroupName );
-				dsMesh->deselectAllFacets();
+			}
+			facetIndices = remapped;
+		}
+	}
+	if ( !asFaceGroups )
+	{
+		for ( int i = 0, n = polygonSets.count(); i < n; i++ )
+		{
+			const PolygonSet &polygonSet = polygonSets.at( i );
+			const QString &dsFaceGroupName = polygonSet.faceGroupName;
+			const QVector<int> &facetIndices = polygonSet.facetIndices;
 
 #if DZ_SDK_4_12_OR_GREATER
-				dsMesh->finishFacetSelectionEdit();
-#else
-				// DzFacetMesh::beginFacetSelectionEdit() is not in the 4.5 SDK,
-				// so we attempt to use the meta-object to call the method - since 4.6.3.39
-
-				im = QMetaObject::invokeMethod( dsMesh, "finishFacetSelectionEdit" );
-				assert( im );
-#endif
-			}
-			else // as a selection group
+			DzSelectionGroup* dsSelectionGrp = dsShape->findFacetSelectionGroup( dsFaceGroupName, true );
+			for ( int k = 0; k < facetIndices.count(); k++ )
 			{
-#if DZ_SDK_4_12_OR_GREATER
-				DzSelectionGroup* dsSelectionGrp = dsShape->findFacetSelectionGroup( dsFaceGroupName, true );
-				for ( int k = 0; k < fbxFacetIndices.GetCount(); k++ )
-				{
-					dsSelectionGrp->addIndex( fbxFacetIndices.GetAt( k ) );
-				}
+				dsSelectionGrp->addIndex( facetIndices.at( k ) );
+			}
 #else
-				// DzSelectionGroup is not in the 4.5 SDK, but its superclass
-				// DzIndexList is and it provides DzIndexList::addIndex()
+			// DzSelectionGroup is not in the 4.5 SDK, but its superclass
+			// DzIndexList is and it provides DzIndexList::addIndex()
 
-				// DzFacetShape::findFacetSelectionGroup() is not in the 4.5 SDK,
-				// so we attempt to use the meta-object to call the method - since 4.6.3.39
+			// DzFacetShape::findFacetSelectionGroup() is not in the 4.5 SDK,
+			// so we attempt to use the meta-object to call the method - since 4.6.3.39
 
-				DzIndexList* dsSelectionGrp = NULL;
-				if ( QMetaObject::invokeMethod( dsShape, "findFacetSelectionGroup",
-						Q_RETURN_ARG( DzIndexList*, dsSelectionGrp ),
-						Q_ARG( const QString&, dsFaceGroupName ), Q_ARG( bool, true ) ) )
+			DzIndexList* dsSelectionGrp = NULL;
+			if ( QMetaObject::invokeMethod( dsShape, "findFacetSelectionGroup",
+					Q_RETURN_ARG( DzIndexList*, dsSelectionGrp ),
+					Q_ARG( const QString&, dsFaceGroupName ), Q_ARG( bool, true ) ) )
+			{
+				for ( int k = 0, p = facetIndices.count(); k < p; k++ )
 				{
-					for ( int k = 0, p = fbxFacetIndices.GetCount(); k < p; k++ )
-					{
-						dsSelectionGrp->addIndex( fbxFacetIndices.GetAt( k ) );
-					}
+					dsSelectionGrp->addIndex( facetIndices.at( k ) );
 				}
-#endif
 			}
+#endif
 		}
 	}
 
@@ -2470,13 +4429,33 @@ void DzFbxImporter::updateSelectionMap( Node* node )
 }
 
 /**
+	Creates the facets of a mesh, in polygon order.
+
+	Polygon sets that are imported as face groups are assigned here, in the
+	same single pass as the materials and polygon groups, by activating the
+	face group of each run of polygons; a polygon belongs to the last set
+	that lists it.
+
+	@param fbxMesh			The mesh to create the facets of.
+	@param dsMesh			The facet mesh to create the facets in.
+	@param weld				The map from control points to vertices.
+	@param matsAllSame		If true, no materials are activated.
+	@param faceGroupSets	The polygon sets to assign as face groups.
+	@param edgeMap			Receives the index of each edge, by control points.
+	@param polygonFacets	Receives the range of facets of each polygon; those
+							of polygon p are [polygonFacets[p], polygonFacets[p + 1]),
+							which is empty if the polygon collapsed.
+
+	@sa fbxImportMesh()
 **/
-void DzFbxImporter::fbxImportFaces( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, bool matsAllSame, QMap<QPair<int, int>, int> &edgeMap )
+void DzFbxImporter::fbxImportFaces( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, const VertexWeld &weld, bool matsAllSame, const QVector<PolygonSet> &faceGroupSets, QMap<QPair<int, int>, int> &edgeMap, QVector<int> &polygonFacets )
 {
 	int numEdges = 0;
 
 	const int numPolygons = fbxMesh->GetPolygonCount();
 
+	polygonFacets.resize( numPolygons + 1 );
+
 	const FbxGeometryElementPolygonGroup* fbxPolygonGroup = m_includePolygonGroups ?
 		fbxMesh->GetElementPolygonGroup( 0 ) : NULL;
 
@@ -2485,22 +4464,87 @@ void DzFbxImporter::fbxImportFaces( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, bool
 	// count is as expected with FBX SDK 2019.5 and prior
 	const bool compatPolyGroup = fbxPolygonGroup && numPolygons == fbxPolygonGroup->GetIndexArray().GetCount();
 
+	// resolve the material of every polygon in a single pass over the material
+	// elements; the first element with a valid index for a polygon wins
+	QVector<int> polyMaterials;
+	if ( !matsAllSame )
+	{
+		polyMaterials.fill( -1, numPolygons );
+		for ( int matElemIdx = 0, numMatElements = fbxMesh->GetElementMaterialCount();
+			matElemIdx < numMatElements; matElemIdx++ )
+		{
+			const FbxGeometryElementMaterial* fbxMaterial = fbxMesh->GetElementMaterial( matElemIdx );
+			const FbxLayerElementArrayTemplate<int> &fbxMatIndices = fbxMaterial->GetIndexArray();
+			for ( int polyIdx = 0, numMatIndices = qMin( numPolygons, fbxMatIndices.GetCount() );
+				polyIdx < numMatIndices; polyIdx++ )
+			{
+				if ( polyMaterials[polyIdx] < 0 )
+				{
+					polyMaterials[polyIdx] = fbxMatIndices.GetAt( polyIdx );
+				}
+			}
+		}
+	}
+
+	// resolve the face group set of every polygon
+	QStringList setNames;
+	QVector<int> polySets;
+	if ( !faceGroupSets.isEmpty() )
+	{
+		polySets.fill( -1, numPolygons );
+
+		QHash<QString, int> setIndices;
+		for ( int i = 0, n = faceGroupSets.count(); i < n; i++ )
+		{
+			const PolygonSet &polygonSet = faceGroupSets.at( i );
+
+			int setIdx = setIndices.value( polygonSet.faceGroupName, -1 );
+			if ( setIdx < 0 )
+			{
+				setIdx = setNames.count();
+				setNames.append( polygonSet.faceGroupName );
+				setIndices.insert( polygonSet.faceGroupName, setIdx );
+			}
+
+			const int* polyIndices = polygonSet.facetIndices.constData();
+			for ( int j = 0, m = polygonSet.facetIndices.count(); j < m; j++ )
+			{
+				const int setPolyIdx = polyIndices[j];
+				if ( setPolyIdx >= 0 && setPolyIdx < numPolygons )
+				{
+					polySets[setPolyIdx] = setIdx;
+				}
+			}
+		}
+	}
+
+	// polygons that are in no set return to the face group that was active
+	// before any set was; a new mesh only has the group it was created with,
+	// which is the last. Without one, a group has to be created regardless
+	QString baseFaceGroup( "default" );
+	if ( !polySets.isEmpty()
+		&& dsMesh->getNumFaceGroups() > 0 )
+	{
+		baseFaceGroup = dsMesh->getFaceGroup( dsMesh->getNumFaceGroups() - 1 )->getName();
+	}
+
+	// facets must stay in polygon order (polygon sets refer to them by index),
+	// so materials and face groups are only activated at the start of each run
+	QHash<int, QString> groupNames;
+
+	int curMatIdx = -1;
 	int curGroupIdx = -1;
+	int curSetIdx = -1;
 	for ( int polyIdx = 0; polyIdx < numPolygons; polyIdx++ )
 	{
 		// active material group
 		if ( !matsAllSame )
 		{
-			for ( int matElemIdx = 0, numMatElements = fbxMesh->GetElementMaterialCount();
-				matElemIdx < numMatElements; matElemIdx++ )
+			const int polyMatIdx = polyMaterials[polyIdx];
+			if ( polyMatIdx >= 0 && polyMatIdx != curMatIdx )
 			{
-				const FbxGeometryElementMaterial* fbxMaterial = fbxMesh->GetElementMaterial( matElemIdx );
-				const int polyMatIdx = fbxMaterial->GetIndexArray().GetAt( polyIdx );
-				if ( polyMatIdx >= 0 )
-				{
-					dsMesh->activateMaterial( polyMatIdx );
-					break;
-				}
+				curMatIdx = polyMatIdx;
+				dsMesh->activateMaterial( polyMatIdx );
 			}
 		}
 
@@ -2511,22 +4555,71 @@ void DzFbxImporter::fbxImportFaces( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, bool
 			if ( groupIdx != curGroupIdx )
 			{
 				curGroupIdx = groupIdx;
-				dsMesh->activateFaceGroup( "fbx_polygonGroup_" % QString::number( groupIdx ) );
+
+				QHash<int, QString>::iterator groupNameIt = groupNames.find( groupIdx );
+				if ( groupNameIt == groupNames.end() )
+				{
+					groupNameIt = groupNames.insert( groupIdx, "fbx_polygonGroup_" % QString::number( groupIdx ) );
+				}
+
+				dsMesh->activateFaceGroup( groupNameIt.value() );
+			}
+		}
+
+		// active polygon set face group
+		if ( !polySets.isEmpty() )
+		{
+			const int setIdx = polySets[polyIdx];
+			if ( setIdx != curSetIdx )
+			{
+				curSetIdx = setIdx;
+				dsMesh->activateFaceGroup( setIdx >= 0 ? setNames.at( setIdx ) : baseFaceGroup );
+			}
+		}
+
+		const int numPolyVerts = fbxMesh->GetPolygonSize( polyIdx );
+
+		// with welding, consecutive corners that weld to the same vertex are
+		// merged, and polygons left with fewer than three corners are dropped
+		QVarLengthArray<int, 8> corners;
+		QVarLengthArray<int, 8> cornerVerts;
+		for ( int polyVertIdx = 0; polyVertIdx < numPolyVerts; polyVertIdx++ )
+		{
+			const int vertIdx = weld.vertex( fbxMesh->GetPolygonVertex( polyIdx, polyVertIdx ) );
+			if ( weld.map.isEmpty()
+				|| cornerVerts.isEmpty()
+				|| vertIdx != cornerVerts[cornerVerts.count() - 1] )
+			{
+				corners.append( polyVertIdx );
+				cornerVerts.append( vertIdx );
 			}
 		}
+		while ( !weld.map.isEmpty()
+			&& cornerVerts.count() > 1
+			&& cornerVerts[cornerVerts.count() - 1] == cornerVerts[0] )
+		{
+			corners.resize( corners.count() - 1 );
+			cornerVerts.resize( cornerVerts.count() - 1 );
+		}
+
+		const bool collapsed = numPolyVerts >= 3 && corners.count() < 3;
+		const int numCorners = collapsed ? 0 : corners.count();
+		polygonFacets[polyIdx] = dsMesh->getNumFacets();
 
 		DzFacet face;
 
 		// facet vertices
 		int triFanRoot = -1;
-		for ( int polyVertIdx = 0, numPolyVerts = fbxMesh->GetPolygonSize( polyIdx );
-			polyVertIdx < numPolyVerts; polyVertIdx++ )
+		for ( int cornerIdx = 0; cornerIdx < numCorners; cornerIdx++ )
 		{
+			const int polyVertIdx = corners[cornerIdx];
+
 			// quads, tris, lines
-			if ( numPolyVerts <= 4 )
+			if ( numCorners <= 4 )
 			{
-				face.m_vertIdx[polyVertIdx] = fbxMesh->GetPolygonVertex( polyIdx, polyVertIdx );
-				face.m_normIdx[polyVertIdx] = face.m_vertIdx[polyVertIdx];
+				const int cpIdx = fbxMesh->GetPolygonVertex( polyIdx, polyVertIdx );
+				face.m_vertIdx[cornerIdx] = weld.vertex( cpIdx );
+				face.m_normIdx[cornerIdx] = face.m_vertIdx[cornerIdx];
 
 				// facet UVs
 				for ( int uvElemIdx = 0, numUvElems = fbxMesh->GetElementUVCount();
@@ -2539,17 +4632,17 @@ void DzFbxImporter::fbxImportFaces( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, bool
 						switch ( fbxGeomUv->GetReferenceMode() )
 						{
 						case FbxGeometryElement::eDirect:
-							face.m_uvwIdx[polyVertIdx] = face.m_vertIdx[polyVertIdx];
+							face.m_uvwIdx[cornerIdx] = cpIdx;
 							break;
 						case FbxGeometryElement::eIndexToDirect:
-							face.m_uvwIdx[polyVertIdx] = fbxGeomUv->GetIndexArray().GetAt( face.m_vertIdx[polyVertIdx] );
+							face.m_uvwIdx[cornerIdx] = fbxGeomUv->GetIndexArray().GetAt( cpIdx );
 							break;
 						default:
 							break;
 						}
 						break;
 					case FbxGeometryElement::eByPolygonVertex:
-						face.m_uvwIdx[polyVertIdx] = fbxMesh->GetTextureUVIndex( polyIdx, polyVertIdx );
+						face.m_uvwIdx[cornerIdx] = fbxMesh->GetTextureUVIndex( polyIdx, polyVertIdx );
 						break;
 					default:
 						break;
@@ -2559,19 +4652,23 @@ void DzFbxImporter::fbxImportFaces( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, bool
 					break;
 				}
 
-				if ( polyVertIdx == numPolyVerts - 1 )
+				if ( cornerIdx == numCorners - 1 )
 				{
 					dsMesh->addFacet( face.m_vertIdx, face.m_uvwIdx );
 				}
 			}
 			// n-gons
-			else if ( polyVertIdx >= 2 )
+			else if ( cornerIdx >= 2 )
 			{
-				const bool isRoot = polyVertIdx == 2;
+				const bool isRoot = cornerIdx == 2;
+
+				const int cpRootIdx = fbxMesh->GetPolygonVertex( polyIdx, corners[0] );
+				const int cpPrevIdx = fbxMesh->GetPolygonVertex( polyIdx, corners[cornerIdx - 1] );
+				const int cpIdx = fbxMesh->GetPolygonVertex( polyIdx, polyVertIdx );
 
-				face.m_vertIdx[0] = fbxMesh->GetPolygonVertex( polyIdx, 0 );
-				face.m_vertIdx[1] = fbxMesh->GetPolygonVertex( polyIdx, polyVertIdx - 1 );
-				face.m_vertIdx[2] = fbxMesh->GetPolygonVertex( polyIdx, polyVertIdx );
+				face.m_vertIdx[0] = weld.vertex( cpRootIdx );
+				face.m_vertIdx[1] = weld.vertex( cpPrevIdx );
+				face.m_vertIdx[2] = weld.vertex( cpIdx );
 				face.m_vertIdx[3] = -1;
 				face.m_normIdx[0] = face.m_vertIdx[0];
 				face.m_normIdx[1] = face.m_vertIdx[1];
@@ -2596,13 +4693,13 @@ void DzFbxImporter::fbxImportFaces( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, bool
 				if ( isRoot )
 				{
 #if DZ_SDK_4_12_OR_GREATER
-					face.setTriFanCount( numPolyVerts - 2 );
+					face.setTriFanCount( numCorners - 2 );
 #else
 					// DzFacet::setTriFanCount() is not in the 4.5 SDK, and DzFacet
 					// is not derived from QObject, so we must modify the member
 					// directly.
 
-					face.m_edges[3] = -numPolyVerts;
+					face.m_edges[3] = -numCorners;
 #endif
 				}
 				else
@@ -2629,15 +4726,15 @@ void DzFbxImporter::fbxImportFaces( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, bool
 						switch ( fbxGeomUv->GetReferenceMode() )
 						{
 						case FbxGeometryElement::eDirect:
-							face.m_uvwIdx[0] = face.m_vertIdx[0];
-							face.m_uvwIdx[1] = face.m_vertIdx[polyVertIdx - 1];
-							face.m_uvwIdx[2] = face.m_vertIdx[polyVertIdx];
+							face.m_uvwIdx[0] = cpRootIdx;
+							face.m_uvwIdx[1] = cpPrevIdx;
+							face.m_uvwIdx[2] = cpIdx;
 							face.m_uvwIdx[3] = -1;
 							break;
 						case FbxGeometryElement::eIndexToDirect:
-							face.m_uvwIdx[0] = fbxGeomUv->GetIndexArray().GetAt( face.m_vertIdx[0] );
-							face.m_uvwIdx[1] = fbxGeomUv->GetIndexArray().GetAt( face.m_vertIdx[polyVertIdx - 1] );
-							face.m_uvwIdx[2] = fbxGeomUv->GetIndexArray().GetAt( face.m_vertIdx[polyVertIdx] );
+							face.m_uvwIdx[0] = fbxGeomUv->GetIndexArray().GetAt( cpRootIdx );
+							face.m_uvwIdx[1] = fbxGeomUv->GetIndexArray().GetAt( cpPrevIdx );
+							face.m_uvwIdx[2] = fbxGeomUv->GetIndexArray().GetAt( cpIdx );
 							face.m_uvwIdx[3] = -1;
 							break;
 						default:
@@ -2645,8 +4742,8 @@ void DzFbxImporter::fbxImportFaces( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, bool
 						}
 						break;
 					case FbxGeometryElement::eByPolygonVertex:
-						face.m_uvwIdx[0] = fbxMesh->GetTextureUVIndex( polyIdx, polyVertIdx );
-						face.m_uvwIdx[1] = fbxMesh->GetTextureUVIndex( polyIdx, polyVertIdx - 1 );
+						face.m_uvwIdx[0] = fbxMesh->GetTextureUVIndex( polyIdx, corners[0] );
+						face.m_uvwIdx[1] = fbxMesh->GetTextureUVIndex( polyIdx, corners[cornerIdx - 1] );
 						face.m_uvwIdx[2] = fbxMesh->GetTextureUVIndex( polyIdx, polyVertIdx );
 						face.m_uvwIdx[3] = -1;
 						break;
@@ -2658,129 +4755,499 @@ void DzFbxImporter::fbxImportFaces( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, bool
 					break;
 				}
 
-#if DZ_SDK_4_12_OR_GREATER
-				dsMesh->addFacet( face );
-#else
-				// DzFacetMesh::addFacet() is not in the 4.5 SDK, so we attempt
-				// to use the meta-object to call the method.
+#if DZ_SDK_4_12_OR_GREATER
+				dsMesh->addFacet( face );
+#else
+				// DzFacetMesh::addFacet() is not in the 4.5 SDK, so we attempt
+				// to use the meta-object to call the method.
+
+				bool im = QMetaObject::invokeMethod( dsMesh, "addFacet",
+					Q_ARG( const DzFacet &, face ) );
+				assert( im );
+#endif
+
+				if ( isRoot )
+				{
+#if DZ_SDK_4_12_OR_GREATER
+					dsMesh->incrementNgons();
+#else
+					// DzFacetMesh::incrementNgons() is not in the 4.5 SDK, so
+					// we attempt to use the meta-object to call the method.
+
+					bool im = QMetaObject::invokeMethod( dsMesh, "incrementNgons" );
+					assert( im );
+#endif
+				}
+			}
+		}
+
+		// edges
+		for ( int polyVertIdx = 0; polyVertIdx < numPolyVerts; polyVertIdx++ )
+		{
+			const int polyVertNextIdx = (polyVertIdx + 1) % numPolyVerts;
+
+			const int edgeVertA = fbxMesh->GetPolygonVertex( polyIdx, polyVertIdx );
+			const int edgeVertB = fbxMesh->GetPolygonVertex( polyIdx, polyVertNextIdx );
+			QPair<int, int> edgeVertPair( qMin( edgeVertA, edgeVertB ), qMax( edgeVertA, edgeVertB ) );
+			if ( !edgeMap.contains( edgeVertPair ) )
+			{
+				edgeMap[edgeVertPair] = numEdges;
+				numEdges++;
+			}
+		}
+	}
+
+	polygonFacets[numPolygons] = dsMesh->getNumFacets();
+}
+
+/**
+**/
+void DzFbxImporter::fbxImportSubdEdgeWeights( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, const VertexWeld &weld, QMap<QPair<int, int>, int> edgeMap, bool &enableSubd )
+{
+	for ( int i = 0, n = fbxMesh->GetElementEdgeCreaseCount(); i < n; i++ )
+	{
+		const FbxGeometryElementCrease* fbxSubdEdgeCrease = fbxMesh->GetElementEdgeCrease( i );
+		const int numCreases = fbxSubdEdgeCrease->GetDirectArray().GetCount();
+		Q_UNUSED( numCreases )
+
+		QMap< QPair<int, int>, int >::iterator edgeMapIt;
+		for ( edgeMapIt = edgeMap.begin(); edgeMapIt != edgeMap.end(); ++edgeMapIt )
+		{
+			const int edgeIdx = edgeMapIt.value();
+			const float weight = fbxSubdEdgeCrease->GetDirectArray().GetAt( edgeIdx );
+			const int edgeVertA = weld.vertex( edgeMapIt.key().first );
+			const int edgeVertB = weld.vertex( edgeMapIt.key().second );
+			if ( weight > 0 )
+			{
+				enableSubd = true;
+#if DZ_SDK_4_12_OR_GREATER
+				dsMesh->setEdgeWeight( edgeVertA, edgeVertB, weight );
+#else
+				// DzFacetMesh::setEdgeWeight() is not in the 4.5 SDK, so we
+				// attempt to use the meta-object to call the method.
+
+				bool im = QMetaObject::invokeMethod( dsMesh, "setEdgeWeight",
+					Q_ARG( int, edgeVertA ), Q_ARG( int, edgeVertB ), Q_ARG( int, weight ) );
+				assert( im );
+#endif
+			}
+		}
+
+		// only do the first
+		break;
+	}
+}
+
+namespace
+{
+
+const double c_morphDeltaEpsilon = 1e-6;
+
+/**
+	@return	true if every component of a morph delta is within an epsilon of
+			zero, so that numerically insignificant deltas are not stored.
+**/
+bool isZeroDelta( const DzVec3 &delta )
+{
+	return qAbs( delta.m_x ) <= c_morphDeltaEpsilon
+		&& qAbs( delta.m_y ) <= c_morphDeltaEpsilon
+		&& qAbs( delta.m_z ) <= c_morphDeltaEpsilon;
+}
+
+const double c_morphDeltaSteps = 32767.0;
+
+/**
+	@return	The delta with each component rounded to a multiple of the step.
+**/
+DzVec3 quantizeDelta( const DzVec3 &delta, double step )
+{
+	return DzVec3(
+		qRound( delta.m_x / step ) * step,
+		qRound( delta.m_y / step ) * step,
+		qRound( delta.m_z / step ) * step );
+}
+
+/**
+	@return	true if the components of the deltas are exactly equal.
+**/
+bool isSameDeltas( const QVector<DzVec3> &deltas1, const QVector<DzVec3> &deltas2 )
+{
+	if ( deltas1.count() != deltas2.count() )
+	{
+		return false;
+	}
+
+	for ( int i = 0, n = deltas1.count(); i < n; i++ )
+	{
+		if ( deltas1[i].m_x != deltas2[i].m_x
+			|| deltas1[i].m_y != deltas2[i].m_y
+			|| deltas1[i].m_z != deltas2[i].m_z )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+	@return	The property that controls the value of the morph.
+**/
+DzFloatProperty* getMorphControl( DzMorph* dsMorph )
+{
+#if DZ_SDK_4_12_OR_GREATER
+	return dsMorph->getValueControl();
+#else
+	// DzMorph::getValueControl() is not in the 4.5 SDK, but DzMorph::getValueChannel()
+	// was, so we use the previous name.
+
+	return dsMorph->getValueChannel();
+#endif
+}
+
+} //namespace
+
+/**
+	Gathers the deltas of the target shapes of a blend shape channel from the
+	control points that each target lists, or from every control point if a
+	target has no index list, without a dense buffer per vertex. Deltas whose
+	components are all within an epsilon of zero are dropped.
+
+	The last target is the full shape of the channel; any before it are
+	in-betweens. All targets share one sorted index list: the deltas of the
+	full target are aligned with it, and the deltas of the in-betweens follow
+	one another in a single stack, with zeros where an in-between does not
+	move a vertex that another target does.
+
+	This only reads the arrays referenced by the channel, and does not call
+	into the FBX SDK, so channels can be gathered concurrently.
+
+	@param weld			The map from control points to vertices.
+	@param fbxVertices	The control points of the mesh.
+	@param channel		The targets of the channel to gather the deltas of.
+	@param morphDeltas	Receives the deltas.
+
+	@sa fbxImportMorph()
+**/
+void DzFbxImporter::gatherMorphDeltas( const VertexWeld &weld, const FbxVector4* fbxVertices, const MorphChannel &channel, MorphDeltas &morphDeltas )
+{
+	morphDeltas.indices.clear();
+	morphDeltas.deltas.clear();
+	morphDeltas.inBetweenWeights.clear();
+	morphDeltas.inBetweenDeltas.clear();
+
+	const int numTgtShapes = channel.targets.count();
+	if ( numTgtShapes < 1 )
+	{
+		return;
+	}
+
+	QVector<int> gatheredVerts;
+	QVector<int> gatheredTargets;
+	QVector<DzVec3> gatheredDeltas;
+	bool sorted = true;
+
+	for ( int tgtShapeIdx = 0; tgtShapeIdx < numTgtShapes; tgtShapeIdx++ )
+	{
+		const MorphTarget &target = channel.targets[tgtShapeIdx];
+		const FbxVector4* fbxTargetShapeVerts = target.controlPoints;
+		const int* fbxTgtShapeVertIndices = target.indices;
+		const int numTgtShapeVerts = target.count;
+
+		gatheredVerts.reserve( gatheredVerts.count() + numTgtShapeVerts );
+		gatheredTargets.reserve( gatheredTargets.count() + numTgtShapeVerts );
+		gatheredDeltas.reserve( gatheredDeltas.count() + numTgtShapeVerts );
+
+		for ( int i = 0; i < numTgtShapeVerts; i++ )
+		{
+			const int cpIdx = fbxTgtShapeVertIndices ? fbxTgtShapeVertIndices[i] : i;
+			if ( !weld.contains( cpIdx )
+				|| !weld.isSource( cpIdx ) )
+			{
+				continue;
+			}
+
+			const DzVec3 delta(
+				fbxTargetShapeVerts[cpIdx][0] - fbxVertices[cpIdx][0],
+				fbxTargetShapeVerts[cpIdx][1] - fbxVertices[cpIdx][1],
+				fbxTargetShapeVerts[cpIdx][2] - fbxVertices[cpIdx][2] );
+			if ( isZeroDelta( delta ) )
+			{
+				continue;
+			}
+
+			const int vertIdx = weld.vertex( cpIdx );
+			if ( !gatheredVerts.isEmpty()
+				&& vertIdx <= gatheredVerts.last() )
+			{
+				sorted = false;
+			}
+
+			gatheredVerts.append( vertIdx );
+			gatheredTargets.append( tgtShapeIdx );
+			gatheredDeltas.append( delta );
+		}
+	}
+
+	const int numInBetweens = numTgtShapes - 1;
+	if ( sorted && numInBetweens == 0 )
+	{
+		morphDeltas.indices = gatheredVerts;
+		morphDeltas.deltas = gatheredDeltas;
+		return;
+	}
+
+	// the weights of the in-betweens, relative to the full target
+	const double fullWeight = channel.fullWeights.last();
+	morphDeltas.inBetweenWeights.reserve( numInBetweens );
+	for ( int i = 0; i < numInBetweens; i++ )
+	{
+		morphDeltas.inBetweenWeights.append( fullWeight > 0.0 ?
+			channel.fullWeights[i] / fullWeight :
+			double( i + 1 ) / numTgtShapes );
+	}
+
+	// order by vertex, then by the order the deltas were gathered in, so a
+	// later delta for the same vertex and target replaces an earlier one
+	const int numGathered = gatheredVerts.count();
+	QVector< QPair<int, int> > order( numGathered );
+	for ( int i = 0; i < numGathered; i++ )
+	{
+		order[i] = qMakePair( gatheredVerts[i], i );
+	}
+
+	if ( !sorted )
+	{
+		qSort( order );
+	}
+
+	for ( int i = 0; i < numGathered; i++ )
+	{
+		if ( i == 0
+			|| order[i].first != order[i - 1].first )
+		{
+			morphDeltas.indices.append( order[i].first );
+		}
+	}
+
+	const int numIndices = morphDeltas.indices.count();
+	const DzVec3 zero( 0, 0, 0 );
+	morphDeltas.deltas.fill( zero, numIndices );
+	morphDeltas.inBetweenDeltas.fill( zero, numInBetweens * numIndices );
+
+	int row = -1;
+	for ( int i = 0; i < numGathered; i++ )
+	{
+		if ( i == 0
+			|| order[i].first != order[i - 1].first )
+		{
+			row++;
+		}
+
+		const int gatheredIdx = order[i].second;
+		const int tgtShapeIdx = gatheredTargets[gatheredIdx];
+		if ( tgtShapeIdx == numInBetweens )
+		{
+			morphDeltas.deltas[row] = gatheredDeltas[gatheredIdx];
+		}
+		else
+		{
+			morphDeltas.inBetweenDeltas[tgtShapeIdx * numIndices + row] = gatheredDeltas[gatheredIdx];
+		}
+	}
+}
+
+/**
+	Snaps the deltas of a channel to a fixed-point grid, then drops the
+	vertices that no longer move in any target. Every channel of a blend
+	shape is snapped to the same grid, so channels that differ by less than
+	the step mostly gather to the same deltas, and are found to be duplicates.
+
+	@param morphDeltas	The deltas to quantize.
+	@param step			The spacing of the grid; deltas are left as they are
+						if it is not positive.
 
-				bool im = QMetaObject::invokeMethod( dsMesh, "addFacet",
-					Q_ARG( const DzFacet &, face ) );
-				assert( im );
-#endif
+	@sa hashMorphDeltas()
+**/
+void DzFbxImporter::quantizeMorphDeltas( MorphDeltas &morphDeltas, double step )
+{
+	if ( step <= 0.0 )
+	{
+		return;
+	}
 
-				if ( isRoot )
-				{
-#if DZ_SDK_4_12_OR_GREATER
-					dsMesh->incrementNgons();
-#else
-					// DzFacetMesh::incrementNgons() is not in the 4.5 SDK, so
-					// we attempt to use the meta-object to call the method.
+	const int numIndices = morphDeltas.indices.count();
+	const int numInBetweens = morphDeltas.inBetweenWeights.count();
 
-					bool im = QMetaObject::invokeMethod( dsMesh, "incrementNgons" );
-					assert( im );
-#endif
-				}
-			}
+	MorphDeltas quantized;
+	quantized.inBetweenWeights = morphDeltas.inBetweenWeights;
+	quantized.indices.reserve( numIndices );
+	quantized.deltas.reserve( numIndices );
 
+	QVector<DzVec3> ibDeltas( numInBetweens );
+	QVector< QVector<DzVec3> > ibStack( numInBetweens );
+	for ( int i = 0; i < numIndices; i++ )
+	{
+		const DzVec3 delta = quantizeDelta( morphDeltas.deltas[i], step );
+		bool isZero = isZeroDelta( delta );
+		for ( int ibIdx = 0; ibIdx < numInBetweens; ibIdx++ )
+		{
+			ibDeltas[ibIdx] = quantizeDelta( morphDeltas.inBetweenDeltas[ibIdx * numIndices + i], step );
+			isZero = isZero && isZeroDelta( ibDeltas[ibIdx] );
+		}
 
-			{
-				const int polyVertNextIdx = (polyVertIdx + 1) % numPolyVerts;
+		if ( isZero )
+		{
+			continue;
+		}
 
-				const int edgeVertA = fbxMesh->GetPolygonVertex( polyIdx, polyVertIdx );
-				const int edgeVertB = fbxMesh->GetPolygonVertex( polyIdx, polyVertNextIdx );
-				QPair<int, int> edgeVertPair( qMin( edgeVertA, edgeVertB ), qMax( edgeVertA, edgeVertB ) );
-				if ( !edgeMap.contains( edgeVertPair ) )
-				{
-					edgeMap[edgeVertPair] = numEdges;
-					numEdges++;
-				}
-			}
+		quantized.indices.append( morphDeltas.indices[i] );
+		quantized.deltas.append( delta );
+		for ( int ibIdx = 0; ibIdx < numInBetweens; ibIdx++ )
+		{
+			ibStack[ibIdx].append( ibDeltas[ibIdx] );
 		}
 	}
+
+	for ( int ibIdx = 0; ibIdx < numInBetweens; ibIdx++ )
+	{
+		quantized.inBetweenDeltas += ibStack[ibIdx];
+	}
+
+	morphDeltas = quantized;
 }
 
 /**
+	@param morphDeltas	The deltas of a channel.
+
+	@return	A hash of the indices, weights and deltas of the channel.
+
+	@sa isSameMorphDeltas()
 **/
-void DzFbxImporter::fbxImportSubdEdgeWeights( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, QMap<QPair<int, int>, int> edgeMap, bool &enableSubd )
+uint DzFbxImporter::hashMorphDeltas( const MorphDeltas &morphDeltas )
 {
-	for ( int i = 0, n = fbxMesh->GetElementEdgeCreaseCount(); i < n; i++ )
+	uint hash = qHash( QByteArray::fromRawData(
+		reinterpret_cast<const char*>( morphDeltas.indices.constData() ),
+		morphDeltas.indices.count() * sizeof( int ) ) );
+	hash = hash * 31 + qHash( QByteArray::fromRawData(
+		reinterpret_cast<const char*>( morphDeltas.deltas.constData() ),
+		morphDeltas.deltas.count() * sizeof( DzVec3 ) ) );
+	hash = hash * 31 + qHash( QByteArray::fromRawData(
+		reinterpret_cast<const char*>( morphDeltas.inBetweenWeights.constData() ),
+		morphDeltas.inBetweenWeights.count() * sizeof( double ) ) );
+	hash = hash * 31 + qHash( QByteArray::fromRawData(
+		reinterpret_cast<const char*>( morphDeltas.inBetweenDeltas.constData() ),
+		morphDeltas.inBetweenDeltas.count() * sizeof( DzVec3 ) ) );
+	return hash;
+}
+
+/**
+	@return	true if two channels have exactly the same indices, in-between
+			weights and deltas.
+**/
+bool DzFbxImporter::isSameMorphDeltas( const MorphDeltas &morphDeltas1, const MorphDeltas &morphDeltas2 )
+{
+	return morphDeltas1.hash == morphDeltas2.hash
+		&& morphDeltas1.indices == morphDeltas2.indices
+		&& morphDeltas1.inBetweenWeights == morphDeltas2.inBetweenWeights
+		&& isSameDeltas( morphDeltas1.deltas, morphDeltas2.deltas )
+		&& isSameDeltas( morphDeltas1.inBetweenDeltas, morphDeltas2.inBetweenDeltas );
+}
+
+/**
+	Compiles the patterns of the morph filter, including those read from any
+	pattern files, so that channels are matched without re-parsing them.
+	Relative pattern file paths are resolved against the folder of the FBX
+	file.
+
+	@sa isMorphIncluded()
+**/
+void DzFbxImporter::preImportMorphFilter()
+{
+	m_morphIncludes.clear();
+	m_morphExcludes.clear();
+
+	QStringList patterns;
+	const QStringList entries = m_morphFilter.split( ';', QString::SkipEmptyParts );
+	for ( int i = 0; i < entries.count(); i++ )
 	{
-		const FbxGeometryElementCrease* fbxSubdEdgeCrease = fbxMesh->GetElementEdgeCrease( i );
-		const int numCreases = fbxSubdEdgeCrease->GetDirectArray().GetCount();
-		Q_UNUSED( numCreases )
+		const QString entry = entries[i].trimmed();
+		if ( !entry.startsWith( '@' ) )
+		{
+			patterns.append( entry );
+			continue;
+		}
 
-		QMap< QPair<int, int>, int >::iterator edgeMapIt;
-		for ( edgeMapIt = edgeMap.begin(); edgeMapIt != edgeMap.end(); ++edgeMapIt )
+		QFile file( m_folder.absoluteFilePath( entry.mid( 1 ).trimmed() ) );
+		if ( !file.open( QIODevice::ReadOnly | QIODevice::Text ) )
 		{
-			const int edgeIdx = edgeMapIt.value();
-			const float weight = fbxSubdEdgeCrease->GetDirectArray().GetAt( edgeIdx );
-			const int edgeVertA = edgeMapIt.key().first;
-			const int edgeVertB = edgeMapIt.key().second;
-			if ( weight > 0 )
-			{
-				enableSubd = true;
-#if DZ_SDK_4_12_OR_GREATER
-				dsMesh->setEdgeWeight( edgeVertA, edgeVertB, weight );
-#else
-				// DzFacetMesh::setEdgeWeight() is not in the 4.5 SDK, so we
-				// attempt to use the meta-object to call the method.
+			m_errorList.append( "Morph filter file could not be read: " + file.fileName() );
+			continue;
+		}
 
-				bool im = QMetaObject::invokeMethod( dsMesh, "setEdgeWeight",
-					Q_ARG( int, edgeVertA ), Q_ARG( int, edgeVertB ), Q_ARG( int, weight ) );
-				assert( im );
-#endif
-			}
+		QTextStream stream( &file );
+		while ( !stream.atEnd() )
+		{
+			patterns.append( stream.readLine().trimmed() );
 		}
+	}
 
-		// only do the first
-		break;
+	for ( int i = 0; i < patterns.count(); i++ )
+	{
+		const QString &pattern = patterns[i];
+		if ( pattern.isEmpty()
+			|| pattern.startsWith( '#' ) )
+		{
+			continue;
+		}
+
+		if ( pattern.startsWith( '-' ) )
+		{
+			m_morphExcludes.append( QRegExp( pattern.mid( 1 ), Qt::CaseInsensitive, QRegExp::Wildcard ) );
+		}
+		else
+		{
+			m_morphIncludes.append( QRegExp( pattern, Qt::CaseInsensitive, QRegExp::Wildcard ) );
+		}
 	}
 }
 
 /**
+	@param name	The name of a blend shape channel.
+
+	@return	true if the channel passes the morph filter and should be imported.
 **/
-DzWeightMapPtr DzFbxImporter::fbxImportSkinningBlendWeights( int numVertices, const FbxSkin* fbxSkin )
+bool DzFbxImporter::isMorphIncluded( const QString &name ) const
 {
-	if ( numVertices < 1
-		|| !fbxSkin
-		|| fbxSkin->GetSkinningType() != FbxSkin::eBlend )
+	for ( int i = 0; i < m_morphExcludes.count(); i++ )
 	{
-		return NULL;
+		if ( m_morphExcludes[i].exactMatch( name ) )
+		{
+			return false;
+		}
 	}
 
-	const int numBlendIndices = fbxSkin->GetControlPointIndicesCount();
-	const int* fbxBlendIndices = fbxSkin->GetControlPointIndices();
-	if ( numBlendIndices <= 0 || !fbxBlendIndices )
+	if ( m_morphIncludes.isEmpty() )
 	{
-		return NULL;
+		return true;
 	}
 
-	DzWeightMapPtr dsBlendWeights = new DzWeightMap( numVertices, "Blend Weights" );
-	unsigned short* dsWeightValues = dsBlendWeights->getWeights();
-	for ( int bwIdx = 0; bwIdx < numBlendIndices; ++bwIdx )
+	for ( int i = 0; i < m_morphIncludes.count(); i++ )
 	{
-		const int idx = fbxBlendIndices[bwIdx];
-		if ( idx > numVertices )
+		if ( m_morphIncludes[i].exactMatch( name ) )
 		{
-			continue;
+			return true;
 		}
-
-		const double fbxBlendWeight = fbxSkin->GetControlPointBlendWeights()[bwIdx];
-		dsWeightValues[idx] = DZ_USHORT_MAX * fbxBlendWeight;
 	}
 
-#if DZ_SDK_4_12_OR_GREATER
-	dsBlendWeights->reduceWeightMemory();
-#endif
-
-	return dsBlendWeights;
+	return false;
 }
 
 /**
 **/
-void DzFbxImporter::fbxImportMorph( FbxBlendShape* fbxBlendShape, DzObject* dsObject, int numVertices, FbxVector4* fbxVertices )
+void DzFbxImporter::fbxImportMorph( FbxBlendShape* fbxBlendShape, DzObject* dsObject, const VertexWeld &weld, FbxVector4* fbxVertices )
 {
+	const int numVertices = weld.numVertices;
 	if ( !fbxBlendShape
 		|| !dsObject
 		|| numVertices < 1 )
@@ -2788,91 +5255,212 @@ void DzFbxImporter::fbxImportMorph( FbxBlendShape* fbxBlendShape, DzObject* dsOb
 		return;
 	}
 
-	DzPnt3* values = new DzPnt3[numVertices];
+	// channels that do not pass the filter are skipped before any of their
+	// targets are read
+	QVector<FbxBlendShapeChannel*> fbxBlendChannels;
+	for ( int i = 0, n = fbxBlendShape->GetBlendShapeChannelCount(); i < n; i++ )
+	{
+		FbxBlendShapeChannel* fbxBlendChannel = fbxBlendShape->GetBlendShapeChannel( i );
+		if ( isMorphIncluded( fbxBlendChannel->GetName() ) )
+		{
+			fbxBlendChannels.append( fbxBlendChannel );
+		}
+	}
+
+	const int numBlendShapeChannels = fbxBlendChannels.count();
+	if ( numBlendShapeChannels < 1 )
+	{
+		return;
+	}
+
+	// the arrays of the targets are collected here, since the FBX SDK is not
+	// thread-safe, then the deltas of the channels are gathered concurrently
+	QVector<MorphChannel> channels( numBlendShapeChannels );
+	for ( int blendShapeChanIdx = 0; blendShapeChanIdx < numBlendShapeChannels; blendShapeChanIdx++ )
+	{
+		FbxBlendShapeChannel* fbxBlendChannel = fbxBlendChannels[blendShapeChanIdx];
+		MorphChannel &channel = channels[blendShapeChanIdx];
+
+		const int numTgtShapes = fbxBlendChannel->GetTargetShapeCount();
+		channel.targets.resize( numTgtShapes );
+		channel.fullWeights.resize( numTgtShapes );
+
+		// the full weights are percentages of the channel, in ascending order
+		const double* fbxFullWeights = fbxBlendChannel->GetTargetShapeFullWeights();
+		for ( int tgtShapeIdx = 0; tgtShapeIdx < numTgtShapes; tgtShapeIdx++ )
+		{
+			FbxShape* fbxTargetShape = fbxBlendChannel->GetTargetShape( tgtShapeIdx );
+			MorphTarget &target = channel.targets[tgtShapeIdx];
+			target.controlPoints = fbxTargetShape->GetControlPoints();
+			target.indices = fbxTargetShape->GetControlPointIndices();
+			target.count = target.indices ?
+				fbxTargetShape->GetControlPointIndicesCount() :
+				qMin( fbxTargetShape->GetControlPointsCount(), weld.numControlPoints );
+
+			channel.fullWeights[tgtShapeIdx] = fbxFullWeights ?
+				fbxFullWeights[tgtShapeIdx] :
+				100.0 * ( tgtShapeIdx + 1 ) / numTgtShapes;
+		}
+	}
+
+	// deltas are quantized to a grid with a 16-bit step of the extent of the
+	// mesh, shared by every channel, so that near-identical channels snap
+	// to the same deltas
+	double quantizeStep = 0.0;
+	if ( m_morphQuantizeDeltas
+		&& weld.numControlPoints > 0 )
+	{
+		FbxVector4 bboxMin = fbxVertices[0];
+		FbxVector4 bboxMax = fbxVertices[0];
+		for ( int i = 1; i < weld.numControlPoints; i++ )
+		{
+			for ( int j = 0; j < 3; j++ )
+			{
+				bboxMin[j] = qMin( bboxMin[j], fbxVertices[i][j] );
+				bboxMax[j] = qMax( bboxMax[j], fbxVertices[i][j] );
+			}
+		}
+
+		const double extent = qMax( bboxMax[0] - bboxMin[0],
+			qMax( bboxMax[1] - bboxMin[1], bboxMax[2] - bboxMin[2] ) );
+		quantizeStep = extent / c_morphDeltaSteps;
+	}
+
+	QFuture<MorphDeltas> gathered = QtConcurrent::mapped( channels,
+		MorphDeltaGatherer( weld, fbxVertices, quantizeStep ) );
 
-	const int numBlendShapeChannels = fbxBlendShape->GetBlendShapeChannelCount();
+	// the first channel with each set of deltas, by hash
+	QMultiHash<uint, int> uniqueDeltas;
+	QVector<DzFloatProperty*> morphControls( numBlendShapeChannels, NULL );
 
+	// morphs are created as the deltas of each channel become available
 	DzProgress progress( "Morphs", numBlendShapeChannels );
 	for ( int blendShapeChanIdx = 0; blendShapeChanIdx < numBlendShapeChannels; blendShapeChanIdx++ )
 	{
-		FbxBlendShapeChannel* fbxBlendChannel = fbxBlendShape->GetBlendShapeChannel( blendShapeChanIdx );
+		FbxBlendShapeChannel* fbxBlendChannel = fbxBlendChannels[blendShapeChanIdx];
 
 		DzMorph* dsMorph = new DzMorph;
 		dsMorph->setName( fbxBlendChannel->GetName() );
 		DzMorphDeltas* dsDeltas = dsMorph->getDeltas();
+		DzFloatProperty* morphControl = getMorphControl( dsMorph );
+
+		applyFbxCurve( fbxBlendChannel->DeformPercent.GetCurve( m_fbxAnimLayer ), morphControl, c_minMorphKeyTolerance, 0.01 );
+
+		const MorphDeltas morphDeltas = gathered.resultAt( blendShapeChanIdx );
+		morphControls[blendShapeChanIdx] = morphControl;
+
+		// if enabled, a channel with the same deltas as an earlier one, such
+		// as a copy exported twice or a legacy alias, adds its value to the
+		// morph of that channel instead of storing the deltas again; its own
+		// morph is kept without deltas, for the control. This changes the
+		// result: the earlier control shows the sum, which is clamped to its
+		// limits. Channels with in-betweens are not aliased, since their
+		// correctives are driven by the value of their own channel, not the sum
+		DzFloatProperty* aliasedControl = NULL;
+		if ( m_morphShareDuplicates
+			&& !morphDeltas.indices.isEmpty()
+			&& morphDeltas.inBetweenWeights.isEmpty() )
+		{
+			QMultiHash<uint, int>::const_iterator uniqueIt = uniqueDeltas.constFind( morphDeltas.hash );
+			for ( ; uniqueIt != uniqueDeltas.constEnd() && uniqueIt.key() == morphDeltas.hash; ++uniqueIt )
+			{
+				if ( isSameMorphDeltas( gathered.resultAt( uniqueIt.value() ), morphDeltas ) )
+				{
+					aliasedControl = morphControls[uniqueIt.value()];
+					break;
+				}
+			}
+		}
 
-		DzFloatProperty* morphControl = NULL;
-#if DZ_SDK_4_12_OR_GREATER
-		morphControl = dsMorph->getValueControl();
-#else
-		// DzMorph::getValueControl() is not in the 4.5 SDK, but DzMorph::getValueChannel()
-		// was, so we use the previous name.
-
-		morphControl = dsMorph->getValueChannel();
-#endif
+		if ( aliasedControl )
+		{
+			aliasedControl->insertController( new DzERCLink( DzERCLink::ERCDeltaAdd, morphControl, 1.0, 0.0 ) );
+			dsObject->addModifier( dsMorph );
 
-		applyFbxCurve( fbxBlendChannel->DeformPercent.GetCurve( m_fbxAnimLayer ), morphControl, 0.01 );
+			progress.step();
+			continue;
+		}
 
-		for ( int vertIdx = 0; vertIdx < numVertices; vertIdx++ )
+		if ( m_morphShareDuplicates
+			&& morphDeltas.inBetweenWeights.isEmpty() )
 		{
-			values[vertIdx][0] = 0;
-			values[vertIdx][1] = 0;
-			values[vertIdx][2] = 0;
+			uniqueDeltas.insert( morphDeltas.hash, blendShapeChanIdx );
 		}
 
-		for ( int tgtShapeIdx = 0, numTgtShapes = fbxBlendChannel->GetTargetShapeCount();
-			tgtShapeIdx < numTgtShapes; tgtShapeIdx++ )
+		DzIntArray indexes;
+		DzTArray<DzVec3> deltas;
+		for ( int i = 0, n = morphDeltas.indices.count(); i < n; i++ )
 		{
-			FbxShape* fbxTargetShape = fbxBlendChannel->GetTargetShape( tgtShapeIdx );
-			FbxVector4* fbxTargetShapeVerts = fbxTargetShape->GetControlPoints();
-			int* fbxTgtShapeVertIndices = fbxTargetShape->GetControlPointIndices();
-			//double weight = fbxBlendChannel->GetTargetShapeFullWeights()[k];
+			indexes.append( morphDeltas.indices[i] );
+			deltas.append( morphDeltas.deltas[i] );
+		}
+		dsDeltas->addDeltas( indexes, deltas, false );
+		dsObject->addModifier( dsMorph );
 
-			if ( fbxTgtShapeVertIndices )
+		// each in-between becomes a hidden corrective of its difference from
+		// the full target scaled to its weight, faded in and out by the value
+		// of the channel, so the shape passes through every in-between
+		const int numIndices = morphDeltas.indices.count();
+		const int numInBetweens = morphDeltas.inBetweenWeights.count();
+		double prevWeight = 0.0;
+		for ( int ibIdx = 0; ibIdx < numInBetweens; ibIdx++ )
+		{
+			const double weight = morphDeltas.inBetweenWeights[ibIdx];
+			const double nextWeight = ibIdx + 1 < numInBetweens ?
+				morphDeltas.inBetweenWeights[ibIdx + 1] : 1.0;
+			if ( weight <= prevWeight
+				|| weight >= nextWeight )
 			{
-				for ( int tgtShapeVertIndicesIdx = 0, numTgtShapeVertIndices = fbxTargetShape->GetControlPointIndicesCount();
-					tgtShapeVertIndicesIdx < numTgtShapeVertIndices; tgtShapeVertIndicesIdx++ )
-				{
-					const int vertIdx = fbxTgtShapeVertIndices[tgtShapeVertIndicesIdx];
-					values[vertIdx][0] = fbxTargetShapeVerts[vertIdx][0] - fbxVertices[vertIdx][0];
-					values[vertIdx][1] = fbxTargetShapeVerts[vertIdx][1] - fbxVertices[vertIdx][1];
-					values[vertIdx][2] = fbxTargetShapeVerts[vertIdx][2] - fbxVertices[vertIdx][2];
-				}
+				continue;
 			}
-			else
+
+			const DzVec3* ibDeltas = morphDeltas.inBetweenDeltas.constData() + ibIdx * numIndices;
+			DzIntArray correctiveIndexes;
+			DzTArray<DzVec3> correctiveDeltas;
+			for ( int i = 0; i < numIndices; i++ )
 			{
-				for ( int vertIdx = 0, numTgtShapeVerts = fbxTargetShape->GetControlPointsCount();
-					vertIdx < numTgtShapeVerts; vertIdx++ )
+				const DzVec3 &full = morphDeltas.deltas[i];
+				const DzVec3 corrective(
+					ibDeltas[i].m_x - full.m_x * weight,
+					ibDeltas[i].m_y - full.m_y * weight,
+					ibDeltas[i].m_z - full.m_z * weight );
+				if ( !isZeroDelta( corrective ) )
 				{
-					values[vertIdx][0] = fbxTargetShapeVerts[vertIdx][0] - fbxVertices[vertIdx][0];
-					values[vertIdx][1] = fbxTargetShapeVerts[vertIdx][1] - fbxVertices[vertIdx][1];
-					values[vertIdx][2] = fbxTargetShapeVerts[vertIdx][2] - fbxVertices[vertIdx][2];
+					correctiveIndexes.append( morphDeltas.indices[i] );
+					correctiveDeltas.append( corrective );
 				}
 			}
-		}
 
-		DzIntArray indexes;
-		DzTArray<DzVec3> deltas;
-		for ( int vertIdx = 0; vertIdx < numVertices; vertIdx++ )
-		{
-			if ( values[vertIdx][0] != 0 || values[vertIdx][1] != 0 || values[vertIdx][2] != 0 )
+			if ( correctiveIndexes.count() > 0 )
 			{
-				indexes.append( vertIdx );
-				deltas.append( DzVec3( values[vertIdx][0], values[vertIdx][1], values[vertIdx][2] ) );
+				DzMorph* dsInBetween = new DzMorph;
+				dsInBetween->setName( QString( "%1_ib%2" )
+					.arg( dsMorph->getName() )
+					.arg( qRound( weight * 100 ) ) );
+				dsInBetween->getDeltas()->addDeltas( correctiveIndexes, correctiveDeltas, false );
+
+				DzFloatProperty* inBetweenControl = getMorphControl( dsInBetween );
+				inBetweenControl->setIsHidden( true );
+
+				DzERCLink* dsLink = new DzERCLink( DzERCLink::ERCKeyed, morphControl );
+				dsLink->addKeyValue( prevWeight, 0.0 );
+				dsLink->addKeyValue( weight, 1.0 );
+				dsLink->addKeyValue( nextWeight, 0.0 );
+				inBetweenControl->insertController( dsLink );
+
+				dsObject->addModifier( dsInBetween );
 			}
+
+			prevWeight = weight;
 		}
-		dsDeltas->addDeltas( indexes, deltas, false );
-		dsObject->addModifier( dsMorph );
 
 		progress.step();
 	}
-
-	delete[] values;
 }
 
 /**
 **/
-void DzFbxImporter::fbxImportMeshModifiers( Node* node, FbxMesh* fbxMesh, DzObject* dsObject, DzFigure* dsFigure, int numVertices, FbxVector4* fbxVertices )
+void DzFbxImporter::fbxImportMeshModifiers( Node* node, FbxMesh* fbxMesh, DzObject* dsObject, DzFigure* dsFigure, const VertexWeld &weld, FbxVector4* fbxVertices )
 {
 	for ( int deformerIdx = 0, numDeformers = fbxMesh->GetDeformerCount(); deformerIdx < numDeformers; deformerIdx++ )
 	{
@@ -2890,14 +5478,13 @@ void DzFbxImporter::fbxImportMeshModifiers( Node* node, FbxMesh* fbxMesh, DzObje
 			skinning.node = node;
 			skinning.fbxSkin = fbxSkin;
 			skinning.dsFigure = dsFigure;
-			skinning.numVertices = numVertices;
-			skinning.blendWeights = fbxImportSkinningBlendWeights( numVertices, fbxSkin );
+			skinning.weld = weld;
 			m_skins.push_back( skinning );
 		}
 		// morphs
 		else if ( FbxBlendShape* fbxBlendShape = FbxCast<FbxBlendShape>( fbxDeformer ) )
 		{
-			fbxImportMorph( fbxBlendShape, dsObject, numVertices, fbxVertices );
+			fbxImportMorph( fbxBlendShape, dsObject, weld, fbxVertices );
 		}
 	}
 }
@@ -2946,22 +5533,28 @@ void DzFbxImporter::fbxImportMesh( Node* node, FbxNode* fbxNode, DzNode* dsMeshN
 	// begin the edit
 	dsMesh->beginEdit();
 
-	const int numVertices = fbxMesh->GetControlPointsCount();
+	VertexWeld weld;
+	fbxWeldVertices( fbxMesh, weld );
+	fbxCheckWeldedData( fbxMesh, weld );
+
 	FbxVector4* fbxVertices = fbxMesh->GetControlPoints();
-	fbxImportVertices( numVertices, fbxVertices, dsMesh, offset );
+	fbxImportVertices( weld, fbxVertices, dsMesh, offset );
 
 	fbxImportUVs( fbxMesh, dsMesh );
 
 	bool enableSubd = false;
-	fbxImportSubdVertexWeights( fbxMesh, dsMesh, enableSubd );
+	fbxImportSubdVertexWeights( fbxMesh, dsMesh, weld, enableSubd );
 
 	bool matsAllSame;
 	fbxImportMaterials( fbxNode, fbxMesh, dsMesh, dsShape, matsAllSame );
 
 	QMap< QPair< int, int >, int > edgeMap;
-	fbxImportFaces( fbxMesh, dsMesh, matsAllSame, edgeMap );
+	QVector<int> polygonFacets;
+	const QVector<PolygonSet> faceGroupSets = m_includePolygonSets && !m_includePolygonGroups ?
+		m_polygonSetMap.value( dsMeshNode->getName() ) : QVector<PolygonSet>();
+	fbxImportFaces( fbxMesh, dsMesh, weld, matsAllSame, faceGroupSets, edgeMap, polygonFacets );
 
-	fbxImportSubdEdgeWeights( fbxMesh, dsMesh, edgeMap, enableSubd );
+	fbxImportSubdEdgeWeights( fbxMesh, dsMesh, weld, edgeMap, enableSubd );
 
 	// end the edit
 	dsMesh->finishEdit();
@@ -2973,9 +5566,9 @@ void DzFbxImporter::fbxImportMesh( Node* node, FbxNode* fbxNode, DzNode* dsMeshN
 	dsObject->addShape( dsShape );
 	dsMeshNode->setObject( dsObject );
 
-	fbxImportPolygonSets( dsMeshNode, dsMesh, dsShape );
+	fbxImportPolygonSets( dsMeshNode, dsMesh, dsShape, polygonFacets );
 
-	fbxImportMeshModifiers( node, fbxMesh, dsObject, dsFigure, numVertices, fbxVertices );
+	fbxImportMeshModifiers( node, fbxMesh, dsObject, dsFigure, weld, fbxVertices );
 }
 
 /**
@@ -2996,9 +5589,111 @@ void DzFbxImporter::setSubdEnabled( bool onOff, DzFacetMesh* dsMesh, DzFacetShap
 	}
 }
 
+namespace
+{
+
+/**
+	Marks the keys of a curve that are needed to reproduce it, by linear
+	interpolation between the kept keys, within a tolerance; using an
+	iterative Douglas-Peucker simplification. The first and last keys are
+	always kept.
+
+	@param times		The times of the keys, in ascending order.
+	@param values		The values of the keys.
+	@param tolerance	The largest difference in value allowed.
+	@param keep			Receives whether each key is kept.
+**/
+void reduceKeys( const QVector<double> &times, const QVector<double> &values, double tolerance, QVector<bool> &keep )
+{
+	const int numKeys = times.count();
+	keep.fill( false, numKeys );
+	if ( numKeys < 1 )
+	{
+		return;
+	}
+
+	keep[0] = true;
+	keep[numKeys - 1] = true;
+
+	QVector< QPair<int, int> > spans;
+	spans.append( qMakePair( 0, numKeys - 1 ) );
+	while ( !spans.isEmpty() )
+	{
+		const QPair<int, int> span = spans.last();
+		spans.pop_back();
+
+		const int first = span.first;
+		const int last = span.second;
+		const double duration = times[last] - times[first];
+
+		int worstIdx = -1;
+		double worstError = tolerance;
+		for ( int i = first + 1; i < last; i++ )
+		{
+			const double t = duration > 0.0 ? ( times[i] - times[first] ) / duration : 0.0;
+			const double interpolated = values[first] + ( values[last] - values[first] ) * t;
+			const double error = qAbs( values[i] - interpolated );
+			if ( error > worstError )
+			{
+				worstError = error;
+				worstIdx = i;
+			}
+		}
+
+		if ( worstIdx < 0 )
+		{
+			continue;
+		}
+
+		keep[worstIdx] = true;
+		spans.append( qMakePair( first, worstIdx ) );
+		spans.append( qMakePair( worstIdx, last ) );
+	}
+}
+
+/**
+	@return	The index of the count-th kept key after a key, or before it if
+			count is negative; the first or last key if there are not that
+			many.
+**/
+int findKeptKey( const QVector<bool> &keep, int idx, int count )
+{
+	const int step = count < 0 ? -1 : 1;
+	for ( int n = qAbs( count ); n > 0; n-- )
+	{
+		do
+		{
+			idx += step;
+		}
+		while ( idx > 0 && idx < keep.count() - 1 && !keep[idx] );
+
+		if ( idx <= 0 || idx >= keep.count() - 1 )
+		{
+			return qBound( 0, idx, keep.count() - 1 );
+		}
+	}
+
+	return idx;
+}
+
+} //namespace
+
 /**
+	Copies the keys of an FBX animation curve to a property. If key reduction
+	is enabled, keys that linear interpolation between the remaining keys
+	reproduces within the tolerance, relative to the range of values of the
+	curve but no less than the minimum tolerance, are not copied; a curve
+	whose range is within the tolerance is reduced to a single key. Since the
+	property does not interpolate linearly, the keys that were not copied are
+	then checked against the value of the property, and restored if it is not
+	within the tolerance. Curves with stepped keys are not reduced.
+
+	@param fbxCurve		The curve to copy the keys of.
+	@param dsProperty	The property to key.
+	@param minTolerance	The smallest tolerance, in the units of the property.
+	@param scale		The factor that values are scaled by.
 **/
-void DzFbxImporter::applyFbxCurve( FbxAnimCurve* fbxCurve, DzFloatProperty* dsProperty, double scale )
+void DzFbxImporter::applyFbxCurve( FbxAnimCurve* fbxCurve, DzFloatProperty* dsProperty, double minTolerance, double scale )
 {
 	if ( !fbxCurve || !dsProperty )
 	{
@@ -3007,14 +5702,84 @@ void DzFbxImporter::applyFbxCurve( FbxAnimCurve* fbxCurve, DzFloatProperty* dsPr
 
 	dsProperty->deleteAllKeys();
 
-	for ( int i = 0; i < fbxCurve->KeyGetCount(); i++ )
+	const int numKeys = fbxCurve->KeyGetCount();
+	QVector<double> times( numKeys );
+	QVector<double> values( numKeys );
+	QVector<DzTime> dsTimes( numKeys );
+	double minValue = 0.0;
+	double maxValue = 0.0;
+	bool hasConstantKeys = false;
+	for ( int i = 0; i < numKeys; i++ )
+	{
+		times[i] = fbxCurve->KeyGetTime( i ).GetSecondDouble();
+		values[i] = fbxCurve->KeyGetValue( i ) * scale;
+
+		dsTimes[i] = static_cast< DzTime >((times[i] * DZ_TICKS_PER_SECOND) + 0.5f); //round to nearest tick
+		m_dsEndTime = qMax( m_dsEndTime, dsTimes[i] );
+
+		minValue = i == 0 ? values[i] : qMin( minValue, values[i] );
+		maxValue = i == 0 ? values[i] : qMax( maxValue, values[i] );
+
+		// the interpolation of the last key does not affect the curve
+		if ( i < numKeys - 1
+			&& fbxCurve->KeyGetInterpolation( i ) == FbxAnimCurveDef::eInterpolationConstant )
+		{
+			hasConstantKeys = true;
+		}
+	}
+
+	const double tolerance = qMax( m_keyReductionTolerance * ( maxValue - minValue ), minTolerance );
+
+	QVector<bool> keep;
+	if ( m_keyReductionTolerance > 0.0
+		&& numKeys > 2 )
+	{
+		if ( maxValue - minValue <= tolerance )
+		{
+			keep.fill( false, numKeys );
+			keep[0] = true;
+		}
+		else if ( !hasConstantKeys )
+		{
+			reduceKeys( times, values, tolerance, keep );
+		}
+	}
+
+	for ( int i = 0; i < numKeys; i++ )
+	{
+		if ( keep.isEmpty() || keep[i] )
+		{
+			dsProperty->setValue( dsTimes[i], values[i] );
+		}
+	}
+
+	if ( keep.isEmpty() )
+	{
+		return;
+	}
+
+	// restoring a key changes the tangents of the kept keys next to it, and
+	// so the curve up to the second kept key on either side; the keys that
+	// were not copied within that range are checked again, until all of
+	// them are within the tolerance
+	QVector< QPair<int, int> > ranges;
+	ranges.append( qMakePair( 0, numKeys - 1 ) );
+	while ( !ranges.isEmpty() )
 	{
-		const double fbxTime = fbxCurve->KeyGetTime( i ).GetSecondDouble();
-		const double fbxValue = fbxCurve->KeyGetValue( i );
-		DzTime dsTime = static_cast< DzTime >((fbxTime * DZ_TICKS_PER_SECOND) + 0.5f); //round to nearest tick
-		m_dsEndTime = qMax( m_dsEndTime, dsTime );
+		const QPair<int, int> range = ranges.last();
+		ranges.removeLast();
+
+		for ( int i = range.first; i <= range.second; i++ )
+		{
+			if ( !keep[i]
+				&& qAbs( dsProperty->getValue( dsTimes[i] ) - float( values[i] ) ) > tolerance )
+			{
+				dsProperty->setValue( dsTimes[i], values[i] );
+				keep[i] = true;
 
-		dsProperty->setValue( dsTime, fbxValue * scale );
+				ranges.append( qMakePair( findKeptKey( keep, i, -2 ), findKeptKey( keep, i, 2 ) ) );
+			}
+		}
 	}
 }
 
@@ -3029,8 +5794,19 @@ struct DzFbxImportFrame::Data
 		m_includeRotationLimitsCbx( NULL ),
 		m_includeAnimationCbx( NULL ),
 		m_animationTakeCmb( NULL ),
+		m_keyReductionToleranceSpn( NULL ),
 		m_includePolygonSetsCbx( NULL ),
 		m_includePolygonGroupsCbx( NULL ),
+		m_weldVerticesCbx( NULL ),
+		m_weldToleranceSpn( NULL ),
+		m_morphFilterLed( NULL ),
+		m_morphQuantizeDeltasCbx( NULL ),
+		m_morphShareDuplicatesCbx( NULL ),
+		m_minimalFollowerSkeletonsCbx( NULL ),
+		m_skinMaxInfluencesSpn( NULL ),
+		m_skinMinWeightSpn( NULL ),
+		m_textureSearchPathsLed( NULL ),
+		m_textureProxyMaxSizeSpn( NULL ),
 		m_studioNodeNameLabelCbx( NULL ),
 		m_studioPresentationCbx( NULL ),
 		m_studioSelectionMapCbx( NULL ),
@@ -3042,9 +5818,23 @@ struct DzFbxImportFrame::Data
 	QCheckBox*		m_includeRotationLimitsCbx;
 	QCheckBox*		m_includeAnimationCbx;
 	QComboBox*		m_animationTakeCmb;
+	QDoubleSpinBox*	m_keyReductionToleranceSpn;
 
 	QCheckBox*		m_includePolygonSetsCbx;
 	QCheckBox*		m_includePolygonGroupsCbx;
+	QCheckBox*		m_weldVerticesCbx;
+	QDoubleSpinBox*	m_weldToleranceSpn;
+
+	QLineEdit*		m_morphFilterLed;
+	QCheckBox*		m_morphQuantizeDeltasCbx;
+	QCheckBox*		m_morphShareDuplicatesCbx;
+
+	QCheckBox*		m_minimalFollowerSkeletonsCbx;
+	QSpinBox*		m_skinMaxInfluencesSpn;
+	QDoubleSpinBox*	m_skinMinWeightSpn;
+
+	QLineEdit*		m_textureSearchPathsLed;
+	QSpinBox*		m_textureProxyMaxSizeSpn;
 
 	QCheckBox*		m_studioNodeNameLabelCbx;
 	QCheckBox*		m_studioPresentationCbx;
@@ -3355,6 +6145,33 @@ DzFbxImportFrame::DzFbxImportFrame( DzFbxImporter* importer ) :
 	DzConnect( m_data->m_includeAnimationCbx, SIGNAL(toggled(bool)),
 		m_data->m_animationTakeCmb, SLOT(setEnabled(bool)) );
 
+	QHBoxLayout* keyReductionLyt = new QHBoxLayout();
+	keyReductionLyt->setSpacing( margin );
+	keyReductionLyt->setMargin( 0 );
+
+	lbl = new QLabel( tr( "Key Reduction:" ) );
+	lbl->setObjectName( name % "KeyReductionToleranceLbl" );
+	keyReductionLyt->addWidget( lbl );
+
+	m_data->m_keyReductionToleranceSpn = new QDoubleSpinBox();
+	m_data->m_keyReductionToleranceSpn->setObjectName( name % "KeyReductionToleranceSpn" );
+	m_data->m_keyReductionToleranceSpn->setToolTip( tr( "Keys that can be interpolated within this fraction of the range of values of their curve are removed. "
+		"Small fixed tolerances for each kind of channel also remove noise from channels that barely change." ) );
+	m_data->m_keyReductionToleranceSpn->setDecimals( 4 );
+	m_data->m_keyReductionToleranceSpn->setRange( 0.0, 0.1 );
+	m_data->m_keyReductionToleranceSpn->setSingleStep( 0.001 );
+	m_data->m_keyReductionToleranceSpn->setSpecialValueText( tr( "Off" ) );
+	m_data->m_keyReductionToleranceSpn->setFixedHeight( btnHeight );
+	m_data->m_keyReductionToleranceSpn->setEnabled( false );
+	keyReductionLyt->addWidget( m_data->m_keyReductionToleranceSpn, 1 );
+	DzConnect( m_data->m_keyReductionToleranceSpn, SIGNAL(valueChanged(double)),
+		importer, SLOT(setKeyReductionTolerance(double)) );
+
+	DzConnect( m_data->m_includeAnimationCbx, SIGNAL(toggled(bool)),
+		m_data->m_keyReductionToleranceSpn, SLOT(setEnabled(bool)) );
+
+	propertiesLyt->addLayout( keyReductionLyt );
+
 	propertiesGBox->setLayout( propertiesLyt );
 
 	scrollableOptionsLyt->addWidget( propertiesGBox );
@@ -3371,6 +6188,9 @@ DzFbxImportFrame::DzFbxImportFrame( DzFbxImporter* importer ) :
 	m_data->m_includePolygonSetsCbx = new QCheckBox();
 	m_data->m_includePolygonSetsCbx->setObjectName( name % "IncludePolygonSetsCbx" );
 	m_data->m_includePolygonSetsCbx->setText( tr( "Include Polygon Sets" ) );
+	m_data->m_includePolygonSetsCbx->setToolTip( tr( "Polygon selection sets are imported as face groups, or as selection groups if polygon groups are included. "
+		"Set indices are read as polygon indices, so every facet of an n-gon is included; "
+		"files that relied on them being facet indices import differently." ) );
 	geometryLyt->addWidget( m_data->m_includePolygonSetsCbx );
 	DzConnect( m_data->m_includePolygonSetsCbx, SIGNAL(toggled(bool)),
 		importer, SLOT(setIncludePolygonSets(bool)) );
@@ -3382,11 +6202,191 @@ DzFbxImportFrame::DzFbxImportFrame( DzFbxImporter* importer ) :
 	DzConnect( m_data->m_includePolygonGroupsCbx, SIGNAL(toggled(bool)),
 		importer, SLOT(setIncludePolygonGroups(bool)) );
 
+	m_data->m_weldVerticesCbx = new QCheckBox();
+	m_data->m_weldVerticesCbx->setObjectName( name % "WeldVerticesCbx" );
+	m_data->m_weldVerticesCbx->setText( tr( "Weld Coincident Vertices" ) );
+	m_data->m_weldVerticesCbx->setToolTip( tr( "Control points within the tolerance of each other are merged into one vertex. "
+		"Skin weights, morph deltas and crease weights are taken from the first control point of each merged vertex; "
+		"those of the others are discarded, and meshes where they differ are reported. Polygons that collapse are dropped." ) );
+	geometryLyt->addWidget( m_data->m_weldVerticesCbx );
+	DzConnect( m_data->m_weldVerticesCbx, SIGNAL(toggled(bool)),
+		importer, SLOT(setWeldVertices(bool)) );
+
+	QHBoxLayout* weldToleranceLyt = new QHBoxLayout();
+	weldToleranceLyt->setSpacing( margin );
+	weldToleranceLyt->setMargin( 0 );
+
+	lbl = new QLabel( tr( "Weld Tolerance:" ) );
+	lbl->setObjectName( name % "WeldToleranceLbl" );
+	weldToleranceLyt->addWidget( lbl );
+
+	m_data->m_weldToleranceSpn = new QDoubleSpinBox();
+	m_data->m_weldToleranceSpn->setObjectName( name % "WeldToleranceSpn" );
+	m_data->m_weldToleranceSpn->setDecimals( 6 );
+	m_data->m_weldToleranceSpn->setRange( c_minWeldTolerance, c_maxWeldTolerance );
+	m_data->m_weldToleranceSpn->setSingleStep( 0.0001 );
+	m_data->m_weldToleranceSpn->setFixedHeight( btnHeight );
+	m_data->m_weldToleranceSpn->setEnabled( false );
+	weldToleranceLyt->addWidget( m_data->m_weldToleranceSpn, 1 );
+	DzConnect( m_data->m_weldToleranceSpn, SIGNAL(valueChanged(double)),
+		importer, SLOT(setWeldTolerance(double)) );
+
+	DzConnect( m_data->m_weldVerticesCbx, SIGNAL(toggled(bool)),
+		m_data->m_weldToleranceSpn, SLOT(setEnabled(bool)) );
+
+	geometryLyt->addLayout( weldToleranceLyt );
+
 	geometryGBox->setLayout( geometryLyt );
 
 	scrollableOptionsLyt->addWidget( geometryGBox );
 
 
+	// Morphs
+	QGroupBox* morphsGBox = new QGroupBox( tr( "Morphs :" ) );
+	morphsGBox->setObjectName( name % "MorphsGBox" );
+
+	QVBoxLayout* morphsLyt = new QVBoxLayout();
+	morphsLyt->setSpacing( margin );
+	morphsLyt->setMargin( margin );
+
+	lbl = new QLabel( tr( "Filter:" ) );
+	lbl->setObjectName( name % "MorphFilterLbl" );
+	morphsLyt->addWidget( lbl );
+
+	m_data->m_morphFilterLed = new QLineEdit();
+	m_data->m_morphFilterLed->setObjectName( name % "MorphFilterLed" );
+	m_data->m_morphFilterLed->setToolTip( tr( "A semicolon separated list of wildcard patterns of the blend shape channels to import. "
+		"Prefix a pattern with - to exclude the channels it matches, or with @ to read patterns from a file. "
+		"Leave empty to import every channel." ) );
+	m_data->m_morphFilterLed->setFixedHeight( btnHeight );
+	morphsLyt->addWidget( m_data->m_morphFilterLed );
+	DzConnect( m_data->m_morphFilterLed, SIGNAL(textChanged(const QString&)),
+		importer, SLOT(setMorphFilter(const QString&)) );
+
+	m_data->m_morphQuantizeDeltasCbx = new QCheckBox();
+	m_data->m_morphQuantizeDeltasCbx->setObjectName( name % "MorphQuantizeDeltasCbx" );
+	m_data->m_morphQuantizeDeltasCbx->setText( tr( "Quantize Deltas" ) );
+	m_data->m_morphQuantizeDeltasCbx->setToolTip( tr( "Morph deltas are rounded to 1/32767 of the size of the mesh. They are still stored as floats; "
+		"this only drops deltas too small to matter and makes near-identical channels exact duplicates. This is lossy." ) );
+	morphsLyt->addWidget( m_data->m_morphQuantizeDeltasCbx );
+	DzConnect( m_data->m_morphQuantizeDeltasCbx, SIGNAL(toggled(bool)),
+		importer, SLOT(setMorphQuantizeDeltas(bool)) );
+
+	m_data->m_morphShareDuplicatesCbx = new QCheckBox();
+	m_data->m_morphShareDuplicatesCbx->setObjectName( name % "MorphShareDuplicatesCbx" );
+	m_data->m_morphShareDuplicatesCbx->setText( tr( "Share Duplicate Deltas" ) );
+	m_data->m_morphShareDuplicatesCbx->setToolTip( tr( "A channel with the same deltas as an earlier one drives the morph of that channel instead of storing them again. "
+		"The earlier channel then shows the sum of both values, limited to its range." ) );
+	morphsLyt->addWidget( m_data->m_morphShareDuplicatesCbx );
+	DzConnect( m_data->m_morphShareDuplicatesCbx, SIGNAL(toggled(bool)),
+		importer, SLOT(setMorphShareDuplicates(bool)) );
+
+	morphsGBox->setLayout( morphsLyt );
+
+	scrollableOptionsLyt->addWidget( morphsGBox );
+
+
+	// Skinning
+	QGroupBox* skinningGBox = new QGroupBox( tr( "Skinning :" ) );
+	skinningGBox->setObjectName( name % "SkinningGBox" );
+
+	QGridLayout* skinningLyt = new QGridLayout();
+	skinningLyt->setSpacing( margin );
+	skinningLyt->setMargin( margin );
+	skinningLyt->setColumnStretch( 1, 1 );
+
+	row = 0;
+
+	m_data->m_minimalFollowerSkeletonsCbx = new QCheckBox();
+	m_data->m_minimalFollowerSkeletonsCbx->setObjectName( name % "MinimalFollowerSkeletonsCbx" );
+	m_data->m_minimalFollowerSkeletonsCbx->setText( tr( "Minimal Follower Skeletons" ) );
+	m_data->m_minimalFollowerSkeletonsCbx->setToolTip( tr( "Skeletons that follow another only receive the bones their skin is bound to." ) );
+	skinningLyt->addWidget( m_data->m_minimalFollowerSkeletonsCbx, row++, 0, 1, 2 );
+	DzConnect( m_data->m_minimalFollowerSkeletonsCbx, SIGNAL(toggled(bool)),
+		importer, SLOT(setMinimalFollowerSkeletons(bool)) );
+
+	lbl = new QLabel( tr( "Max Influences:" ) );
+	lbl->setObjectName( name % "SkinMaxInfluencesLbl" );
+	skinningLyt->addWidget( lbl, row, 0 );
+
+	m_data->m_skinMaxInfluencesSpn = new QSpinBox();
+	m_data->m_skinMaxInfluencesSpn->setObjectName( name % "SkinMaxInfluencesSpn" );
+	m_data->m_skinMaxInfluencesSpn->setToolTip( tr( "The maximum number of bones that influence a vertex; the strongest are kept." ) );
+	m_data->m_skinMaxInfluencesSpn->setRange( 0, 32 );
+	m_data->m_skinMaxInfluencesSpn->setSpecialValueText( tr( "Unlimited" ) );
+	m_data->m_skinMaxInfluencesSpn->setFixedHeight( btnHeight );
+	skinningLyt->addWidget( m_data->m_skinMaxInfluencesSpn, row++, 1 );
+	DzConnect( m_data->m_skinMaxInfluencesSpn, SIGNAL(valueChanged(int)),
+		importer, SLOT(setSkinMaxInfluences(int)) );
+
+	lbl = new QLabel( tr( "Min Weight:" ) );
+	lbl->setObjectName( name % "SkinMinWeightLbl" );
+	skinningLyt->addWidget( lbl, row, 0 );
+
+	m_data->m_skinMinWeightSpn = new QDoubleSpinBox();
+	m_data->m_skinMinWeightSpn->setObjectName( name % "SkinMinWeightSpn" );
+	m_data->m_skinMinWeightSpn->setToolTip( tr( "Influences weaker than this fraction of the total weight of a vertex are removed." ) );
+	m_data->m_skinMinWeightSpn->setDecimals( 4 );
+	m_data->m_skinMinWeightSpn->setRange( 0.0, 0.5 );
+	m_data->m_skinMinWeightSpn->setSingleStep( 0.001 );
+	m_data->m_skinMinWeightSpn->setSpecialValueText( tr( "Off" ) );
+	m_data->m_skinMinWeightSpn->setFixedHeight( btnHeight );
+	skinningLyt->addWidget( m_data->m_skinMinWeightSpn, row++, 1 );
+	DzConnect( m_data->m_skinMinWeightSpn, SIGNAL(valueChanged(double)),
+		importer, SLOT(setSkinMinWeight(double)) );
+
+	skinningGBox->setLayout( skinningLyt );
+
+	scrollableOptionsLyt->addWidget( skinningGBox );
+
+
+	// Textures
+	QGroupBox* texturesGBox = new QGroupBox( tr( "Textures :" ) );
+	texturesGBox->setObjectName( name % "TexturesGBox" );
+
+	QVBoxLayout* texturesLyt = new QVBoxLayout();
+	texturesLyt->setSpacing( margin );
+	texturesLyt->setMargin( margin );
+
+	lbl = new QLabel( tr( "Search Paths:" ) );
+	lbl->setObjectName( name % "TextureSearchPathsLbl" );
+	texturesLyt->addWidget( lbl );
+
+	m_data->m_textureSearchPathsLed = new QLineEdit();
+	m_data->m_textureSearchPathsLed->setObjectName( name % "TextureSearchPathsLed" );
+	m_data->m_textureSearchPathsLed->setToolTip( tr( "A semicolon separated list of folders to search for texture files that cannot be found at their stored path." ) );
+	m_data->m_textureSearchPathsLed->setFixedHeight( btnHeight );
+	texturesLyt->addWidget( m_data->m_textureSearchPathsLed );
+	DzConnect( m_data->m_textureSearchPathsLed, SIGNAL(textChanged(const QString&)),
+		importer, SLOT(setTextureSearchPaths(const QString&)) );
+
+	QHBoxLayout* textureProxyLyt = new QHBoxLayout();
+	textureProxyLyt->setSpacing( margin );
+	textureProxyLyt->setMargin( 0 );
+
+	lbl = new QLabel( tr( "Proxy Max Size:" ) );
+	lbl->setObjectName( name % "TextureProxyMaxSizeLbl" );
+	textureProxyLyt->addWidget( lbl );
+
+	m_data->m_textureProxyMaxSizeSpn = new QSpinBox();
+	m_data->m_textureProxyMaxSizeSpn->setObjectName( name % "TextureProxyMaxSizeSpn" );
+	m_data->m_textureProxyMaxSizeSpn->setToolTip( tr( "Textures larger than this, in pixels, are replaced by downscaled proxies. "
+		"The path of each original is recorded on the material, next to the map, for final renders." ) );
+	m_data->m_textureProxyMaxSizeSpn->setRange( 0, 16384 );
+	m_data->m_textureProxyMaxSizeSpn->setSingleStep( 256 );
+	m_data->m_textureProxyMaxSizeSpn->setSpecialValueText( tr( "Off" ) );
+	m_data->m_textureProxyMaxSizeSpn->setFixedHeight( btnHeight );
+	textureProxyLyt->addWidget( m_data->m_textureProxyMaxSizeSpn, 1 );
+	DzConnect( m_data->m_textureProxyMaxSizeSpn, SIGNAL(valueChanged(int)),
+		importer, SLOT(setTextureProxyMaxSize(int)) );
+
+	texturesLyt->addLayout( textureProxyLyt );
+
+	texturesGBox->setLayout( texturesLyt );
+
+	scrollableOptionsLyt->addWidget( texturesGBox );
+
+
 	// Custom Data
 	QGroupBox* customDataGBox = new QGroupBox( tr( "Custom Data :" ) );
 	customDataGBox->setObjectName( name % "CustomDataGBox" );
@@ -3515,10 +6515,27 @@ void DzFbxImportFrame::setOptions( const DzFileIOSettings* settings, const QStri
 			break;
 		}
 	}
+	m_data->m_keyReductionToleranceSpn->setValue( settings->getFloatValue( c_optKeyReductionTolerance, c_defaultKeyReductionTolerance ) );
 
 	// Geometry
 	m_data->m_includePolygonSetsCbx->setChecked( settings->getBoolValue( c_optIncPolygonSets, c_defaultIncludePolygonSets ) );
 	m_data->m_includePolygonGroupsCbx->setChecked( settings->getBoolValue( c_optIncPolygonGroups, c_defaultIncludePolygonGroups ) );
+	m_data->m_weldVerticesCbx->setChecked( settings->getBoolValue( c_optWeldVertices, c_defaultWeldVertices ) );
+	m_data->m_weldToleranceSpn->setValue( settings->getFloatValue( c_optWeldTolerance, c_defaultWeldTolerance ) );
+
+	// Morphs
+	m_data->m_morphFilterLed->setText( settings->getStringValue( c_optMorphFilter, c_defaultMorphFilter ) );
+	m_data->m_morphQuantizeDeltasCbx->setChecked( settings->getBoolValue( c_optMorphQuantizeDeltas, c_defaultMorphQuantizeDeltas ) );
+	m_data->m_morphShareDuplicatesCbx->setChecked( settings->getBoolValue( c_optMorphShareDuplicates, c_defaultMorphShareDuplicates ) );
+
+	// Skinning
+	m_data->m_minimalFollowerSkeletonsCbx->setChecked( settings->getBoolValue( c_optMinimalFollowerSkeletons, c_defaultMinimalFollowerSkeletons ) );
+	m_data->m_skinMaxInfluencesSpn->setValue( settings->getIntValue( c_optSkinMaxInfluences, c_defaultSkinMaxInfluences ) );
+	m_data->m_skinMinWeightSpn->setValue( settings->getFloatValue( c_optSkinMinWeight, c_defaultSkinMinWeight ) );
+
+	// Textures
+	m_data->m_textureSearchPathsLed->setText( settings->getStringValue( c_optTextureSearchPaths, c_defaultTextureSearchPaths ) );
+	m_data->m_textureProxyMaxSizeSpn->setValue( settings->getIntValue( c_optTextureProxyMaxSize, c_defaultTextureProxyMaxSize ) );
 
 	// Custom Data
 	m_data->m_studioNodeNameLabelCbx->setChecked( settings->getBoolValue( c_optStudioNodeNamesLabels, c_defaultStudioNodeNames ) );
@@ -3542,10 +6559,27 @@ void DzFbxImportFrame::getOptions( DzFileIOSettings* settings ) const
 	settings->setBoolValue( c_optIncAnimations, m_data->m_includeAnimationCbx->isChecked() );
 	const QString animTake = m_data->m_animationTakeCmb->currentText();
 	settings->setStringValue( c_optTake, animTake != tr( c_none ) ? animTake : QString() );
+	settings->setFloatValue( c_optKeyReductionTolerance, m_data->m_keyReductionToleranceSpn->value() );
 
 	// Geometry
 	settings->setBoolValue( c_optIncPolygonSets, m_data->m_includePolygonSetsCbx->isChecked() );
 	settings->setBoolValue( c_optIncPolygonGroups, m_data->m_includePolygonGroupsCbx->isChecked() );
+	settings->setBoolValue( c_optWeldVertices, m_data->m_weldVerticesCbx->isChecked() );
+	settings->setFloatValue( c_optWeldTolerance, m_data->m_weldToleranceSpn->value() );
+
+	// Morphs
+	settings->setStringValue( c_optMorphFilter, m_data->m_morphFilterLed->text() );
+	settings->setBoolValue( c_optMorphQuantizeDeltas, m_data->m_morphQuantizeDeltasCbx->isChecked() );
+	settings->setBoolValue( c_optMorphShareDuplicates, m_data->m_morphShareDuplicatesCbx->isChecked() );
+
+	// Skinning
+	settings->setBoolValue( c_optMinimalFollowerSkeletons, m_data->m_minimalFollowerSkeletonsCbx->isChecked() );
+	settings->setIntValue( c_optSkinMaxInfluences, m_data->m_skinMaxInfluencesSpn->value() );
+	settings->setFloatValue( c_optSkinMinWeight, m_data->m_skinMinWeightSpn->value() );
+
+	// Textures
+	settings->setStringValue( c_optTextureSearchPaths, m_data->m_textureSearchPathsLed->text() );
+	settings->setIntValue( c_optTextureProxyMaxSize, m_data->m_textureProxyMaxSizeSpn->value() );
 
 	// Custom Data
 	settings->setBoolValue( c_optStudioNodeNamesLabels, m_data->m_studioNodeNameLabelCbx->isChecked() );
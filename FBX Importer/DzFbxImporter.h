@@ -22,10 +22,17 @@
 
 #include <QtCore/QObject>
 #include <QtCore/QDir>
+#include <QtCore/QFuture>
+#include <QtCore/QHash>
 #include <QtCore/QMap>
+#include <QtCore/QPair>
+#include <QtCore/QRegExp>
+#include <QtCore/QSet>
+#include <QtGui/QColor>
 
 #include "dzfileio.h"
 #include "dzimporter.h"
+#include "dztexture.h"
 #include "dzvec3.h"
 #include "dzweightmap.h"
 
@@ -37,6 +44,8 @@
 
 class QComboBox;
 
+class DzClassFactory;
+
 class DzFacetMesh;
 class DzFacetShape;
 class DzFigure;
@@ -100,9 +109,23 @@ public slots:
 	void		setRotationLimits( bool enable );
 	void		setIncludeAnimations( bool enable );
 	void		setTakeName( const QString &name );
+	void		setKeyReductionTolerance( double tolerance );
 
 	void		setIncludePolygonSets( bool enable );
 	void		setIncludePolygonGroups( bool enable );
+	void		setWeldVertices( bool enable );
+	void		setWeldTolerance( double tolerance );
+
+	void		setMorphFilter( const QString &filter );
+	void		setMorphQuantizeDeltas( bool enable );
+	void		setMorphShareDuplicates( bool enable );
+
+	void		setMinimalFollowerSkeletons( bool enable );
+	void		setSkinMaxInfluences( int maxInfluences );
+	void		setSkinMinWeight( double minWeight );
+
+	void		setTextureSearchPaths( const QString &paths );
+	void		setTextureProxyMaxSize( int maxSize );
 
 	void		setStudioNodeNamesLabels( bool enable );
 	void		setStudioNodePresentation( bool enable );
@@ -135,30 +158,6 @@ private:
 			}
 		}
 
-		Node* find( DzNode* inDazNode )
-		{
-			if ( !inDazNode )
-			{
-				return NULL;
-			}
-
-			if ( dsNode == inDazNode )
-			{
-				return this;
-			}
-
-			for ( int i = 0; i < children.count(); i++ )
-			{
-				Node* child = children[i]->find( inDazNode );
-				if ( child )
-				{
-					return child;
-				}
-			}
-
-			return NULL;
-		}
-
 		Node*			parent;
 		QVector<Node*>	children;
 		DzNode*			dsParent;
@@ -168,38 +167,180 @@ private:
 		bool			collapseTranslation;
 	};
 
+	struct VertexWeld
+	{
+		VertexWeld() :
+			numControlPoints( 0 ),
+			numVertices( 0 )
+		{}
+
+		bool contains( int controlPoint ) const
+		{
+			return controlPoint >= 0 && controlPoint < numControlPoints;
+		}
+
+		int vertex( int controlPoint ) const
+		{
+			return map.isEmpty() ? controlPoint : map[controlPoint];
+		}
+
+		int source( int vertex ) const
+		{
+			return sources.isEmpty() ? vertex : sources[vertex];
+		}
+
+		bool isSource( int controlPoint ) const
+		{
+			return map.isEmpty() || sources[map[controlPoint]] == controlPoint;
+		}
+
+		int				numControlPoints;
+		int				numVertices;
+		QVector<int>	map;		// control point -> vertex; empty if not welded
+		QVector<int>	sources;	// vertex -> first control point; empty if not welded
+	};
+
+	struct PolygonSet
+	{
+		QString			faceGroupName;
+		QVector<int>	facetIndices;
+	};
+
 	struct Skinning
 	{
 		Node*		node;
 		FbxSkin*	fbxSkin;
 		DzFigure*	dsFigure;
-		int			numVertices;
-		DzWeightMapPtr	blendWeights;
+		VertexWeld	weld;
+	};
+
+	struct SkinWeights
+	{
+		QVector<int>	begins;		// vertex -> first influence
+		QVector<int>	ends;		// vertex -> one past the last influence
+		QVector<int>	maps;		// influence -> weight map
+		QVector<double>	weights;	// influence -> weight
+
+		QVector<int>	blendVertices;
+		QVector<double>	blendWeights;
+		bool			hasBlendWeights;	// any blend weight is non-zero
+	};
+
+	struct MorphTarget
+	{
+		const FbxVector4*	controlPoints;
+		const int*			indices;	// NULL if every control point is used
+		int					count;		// number of indices or control points
+	};
+
+	struct MorphChannel
+	{
+		QVector<MorphTarget>	targets;
+		QVector<double>			fullWeights;	// percent, per target
+	};
+
+	struct MorphDeltas
+	{
+		QVector<int>	indices;			// sorted vertex indices, shared by every target
+		QVector<DzVec3>	deltas;				// full target, per index
+		QVector<double>	inBetweenWeights;	// relative to the full target
+		QVector<DzVec3>	inBetweenDeltas;	// per in-between, per index
+		uint			hash;
+	};
+
+	class MorphDeltaGatherer {
+	public:
+		typedef MorphDeltas result_type;
+
+		MorphDeltaGatherer( const VertexWeld &weld, const FbxVector4* fbxVertices, double quantizeStep ) :
+			weld( &weld ),
+			fbxVertices( fbxVertices ),
+			quantizeStep( quantizeStep )
+		{}
+
+		MorphDeltas operator()( const MorphChannel &channel ) const
+		{
+			MorphDeltas morphDeltas;
+			gatherMorphDeltas( *weld, fbxVertices, channel, morphDeltas );
+			quantizeMorphDeltas( morphDeltas, quantizeStep );
+			morphDeltas.hash = hashMorphDeltas( morphDeltas );
+			return morphDeltas;
+		}
+
+		const VertexWeld*	weld;
+		const FbxVector4*	fbxVertices;
+		double				quantizeStep;
+	};
+
+	struct MaterialData
+	{
+		bool			forDefaultMaterial;
+		bool			isPhong;
+		QString			name;
+
+		QColor			diffuseColor;
+		DzTexturePtr	diffuseMap;
+		float			diffuseFactor;
+
+		float			opacityBase;
+		DzTexturePtr	opacityMap;
+
+		QColor			ambientColor;
+		DzTexturePtr	ambientMap;
+		float			ambientFactor;
+
+		QColor			specularColor;
+		DzTexturePtr	specularMap;
+		float			specularFactor;
+
+		float			shininess;
+		DzTexturePtr	shininessMap;
+
+		float			reflectionFactor;
+		DzTexturePtr	reflectionMap;
+
+		float			roughness;
+		float			metallicity;
 	};
 
 
 	void		fbxPreImportAnimationStack();
 	void		fbxPreImportGraph( FbxNode* fbxNode );
+	void		fbxPreImportPolygonSets();
+	void		fbxPreImportBindPoses();
+	void		preImportMorphFilter();
 	void		fbxPreImport();
 
+	bool		fbxPrepareEmbeddedMedia( const QString &filename, FbxImporter* fbxImporter, FbxIOSettings* fbxIoSettings );
+	void		fbxFinishEmbeddedMedia( const QString &filename );
+	void		fbxIndexTextureFolders();
+	void		fbxReadAheadTextures();
 	DzTexture*	toTexture( FbxProperty fbxProperty );
 
-	void		fbxImportVertices( int numVertices, FbxVector4* fbxVertices, DzFacetMesh* dsMesh, DzVec3 offset );
+	void		fbxWeldVertices( FbxMesh* fbxMesh, VertexWeld &weld );
+	void		fbxCheckWeldedData( FbxMesh* fbxMesh, const VertexWeld &weld );
+	void		fbxImportVertices( const VertexWeld &weld, FbxVector4* fbxVertices, DzFacetMesh* dsMesh, DzVec3 offset );
 	void		fbxImportUVs( FbxMesh* fbxMesh, DzFacetMesh* dsMesh );
-	void		fbxImportSubdVertexWeights( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, bool &enableSubd );
+	void		fbxImportSubdVertexWeights( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, const VertexWeld &weld, bool &enableSubd );
+	void		fbxTranslateMaterial( FbxSurfaceMaterial* fbxMaterial, bool forDefaultMaterial, MaterialData &matData );
+	void		recordTextureProxyOriginals( DzMaterial* dsMaterial );
 	void		fbxImportMaterials( FbxNode* fbxNode, FbxMesh* fbxMesh, DzFacetMesh* dsMesh, DzFacetShape* dsShape, bool &matsAllSame );
-	void		fbxImportPolygonSets( DzNode* dsMeshNode, DzFacetMesh* dsMesh, DzFacetShape* dsShape );
-	void		fbxImportFaces( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, bool matsAllSame, QMap<QPair<int, int>, int> &edgeMap );
-	void		fbxImportSubdEdgeWeights( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, QMap<QPair<int, int>, int> edgeMap, bool &enableSubd );
-	DzWeightMapPtr	fbxImportSkinningBlendWeights( int numVertices, const FbxSkin* fbxSkin );
-	void		fbxImportMorph( FbxBlendShape* fbxBlendShape, DzObject* dsObject, int numVertices, FbxVector4* fbxVertices );
-	void		fbxImportMeshModifiers( Node* node, FbxMesh* fbxMesh, DzObject* dsObject, DzFigure* dsFigure, int numVertices, FbxVector4* fbxVertices );
+	void		fbxImportPolygonSets( DzNode* dsMeshNode, DzFacetMesh* dsMesh, DzFacetShape* dsShape, const QVector<int> &polygonFacets );
+	void		fbxImportFaces( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, const VertexWeld &weld, bool matsAllSame, const QVector<PolygonSet> &faceGroupSets, QMap<QPair<int, int>, int> &edgeMap, QVector<int> &polygonFacets );
+	void		fbxImportSubdEdgeWeights( FbxMesh* fbxMesh, DzFacetMesh* dsMesh, const VertexWeld &weld, QMap<QPair<int, int>, int> edgeMap, bool &enableSubd );
+	bool		isMorphIncluded( const QString &name ) const;
+	static void	gatherMorphDeltas( const VertexWeld &weld, const FbxVector4* fbxVertices, const MorphChannel &channel, MorphDeltas &morphDeltas );
+	static void	quantizeMorphDeltas( MorphDeltas &morphDeltas, double step );
+	static uint	hashMorphDeltas( const MorphDeltas &morphDeltas );
+	static bool	isSameMorphDeltas( const MorphDeltas &morphDeltas1, const MorphDeltas &morphDeltas2 );
+	void		fbxImportMorph( FbxBlendShape* fbxBlendShape, DzObject* dsObject, const VertexWeld &weld, FbxVector4* fbxVertices );
+	void		fbxImportMeshModifiers( Node* node, FbxMesh* fbxMesh, DzObject* dsObject, DzFigure* dsFigure, const VertexWeld &weld, FbxVector4* fbxVertices );
 	void		fbxImportMesh( Node* node, FbxNode* fbxNode, DzNode* dsMeshNode );
 	void		setSubdEnabled( bool onOff, DzFacetMesh* dsMesh, DzFacetShape* dsShape );
 
-	void		applyFbxCurve( FbxAnimCurve* fbxCurve, DzFloatProperty* dsProperty, double scale = 1 );
+	void		applyFbxCurve( FbxAnimCurve* fbxCurve, DzFloatProperty* dsProperty, double minTolerance, double scale = 1 );
 
-	void		fbxImportGraph( Node* node );
+	void		fbxImportGraph( Node* node, const QSet<FbxNode*>* filter = NULL );
 	void		fbxImportAnimation( Node* node );
 
 	void		updateSelectionMap( Node* node );
@@ -209,12 +350,17 @@ private:
 	void		fbxRead( const QString &filename );
 	void		fbxPickAnimationTake( int idx );
 	void		fbxPickAnimation();
+	DzVec3		getCachedOrigin( DzNode* dsNode );
+	bool		isInFigure( DzNode* dsNode, DzFigure* dsFigure ) const;
+	void		fbxGatherSkinWeights( const VertexWeld &weld, const FbxSkin* fbxSkin, const QVector<FbxCluster*> &clusters, SkinWeights &skinWeights );
+	void		pruneSkinWeights( SkinWeights &skinWeights, int maxInfluences, double minWeight );
 	void		fbxImportSkinning();
 	void		fbxImport();
 	void		fbxCleanup();
 
 
 	bool				m_fbxRead;
+	bool				m_fbxReadSucceeded;
 	FbxManager*			m_fbxManager;
 	FbxScene*			m_fbxScene;
 
@@ -239,8 +385,13 @@ private:
 	FbxString			m_fbxOrigAppVersion;
 
 	QVector<Skinning>		m_skins;
-	QMap<FbxNode*, DzNode*>	m_nodeMap;
+	QHash<FbxNode*, DzNode*>	m_nodeMap;
+	QHash<DzNode*, Node*>	m_importNodeMap;
+	QHash<DzNode*, DzFigure*>	m_figureAncestorMap;
+	QHash<DzNode*, DzVec3>	m_originCache;
 	QMap<Node*, QString>	m_nodeFaceGroupMap;
+	QHash<QString, QVector<PolygonSet> >	m_polygonSetMap;
+	QMultiHash<FbxNode*, QPair<FbxPose*, int> >	m_bindPoseMap;
 	bool					m_needConversion;
 	DzTime					m_dsEndTime;
 
@@ -248,21 +399,46 @@ private:
 	QStringList				m_errorList;
 
 	QDir					m_folder;
+	QString					m_embeddedMediaPath;
+	QMultiHash<QString, QString>	m_textureFileIndex;
+	QHash<QString, DzTexturePtr>	m_textureCache;
+	QHash<const DzTexture*, QString>	m_textureProxyOriginals;
+	QHash<QString, int>		m_textureReadAheadMap;
+	QFuture< QPair<QString, QString> >	m_textureReadAhead;
 
 	QVector<DzMaterial*>	m_dsMaterials;
+	QHash<FbxSurfaceMaterial*, MaterialData>	m_materialDataMap;
 
 	bool		m_includeRotationLimits;
 	bool		m_includeAnimations;
 	QString		m_takeName;
+	double		m_keyReductionTolerance;
 
 	bool		m_includePolygonSets;
 	bool		m_includePolygonGroups;
+	bool		m_weldVertices;
+	double		m_weldTolerance;
+
+	QString			m_morphFilter;
+	bool			m_morphQuantizeDeltas;
+	bool			m_morphShareDuplicates;
+	QList<QRegExp>	m_morphIncludes;
+	QList<QRegExp>	m_morphExcludes;
+
+	bool		m_minimalFollowerSkeletons;
+	int			m_skinMaxInfluences;
+	double		m_skinMinWeight;
+
+	QString		m_textureSearchPaths;
+	int			m_textureProxyMaxSize;
 
 	bool		m_studioNodeNamesLabels;
 	bool		m_studioNodePresentation;
 	bool		m_studioNodeSelectionMap;
 	bool		m_studioSceneIDs;
 
+	const DzClassFactory*	m_pbrMatFactory;
+
 	Node*		m_root;
 };
 